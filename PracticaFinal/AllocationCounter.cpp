@@ -0,0 +1,85 @@
+#include "AllocationCounter.h"
+#include <cstdlib>
+#include <new>
+
+#ifdef ALLOCATION_COUNTER_ENABLED
+
+namespace
+{
+    // Per thread, so the decoding and capture workers don't show up in the game thread
+    thread_local uint64 threadAllocations = 0;
+
+    void* countedAllocate(size_t size)
+    {
+        threadAllocations++;
+        return malloc(size ? size : 1);
+    }
+}
+
+void* operator new(size_t size)
+{
+    void* pointer = countedAllocate(size);
+    if (!pointer)
+        throw std::bad_alloc();
+
+    return pointer;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAllocate(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+    free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+    free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+    free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+    free(pointer);
+}
+
+uint64 GetThreadAllocations()
+{
+    return threadAllocations;
+}
+
+#else
+
+uint64 GetThreadAllocations()
+{
+    return 0;
+}
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include "Common.h"
+
+// Debug builds replace the global operator new to count the heap allocations of each thread,
+// so the game step and the frame can check that they don't allocate.
+#if defined(_DEBUG) && !defined(ALLOCATION_COUNTER_DISABLED)
+#define ALLOCATION_COUNTER_ENABLED
+#endif
+
+// Allocations made so far by the calling thread, always 0 when the counter is disabled
+uint64 GetThreadAllocations();
+
+#endif
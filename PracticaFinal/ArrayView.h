@@ -0,0 +1,30 @@
+#ifndef ARRAY_VIEW_H
+#define ARRAY_VIEW_H
+
+#include "Common.h"
+
+// Read-only range over elements owned by someone else, returned instead of a copied vector
+template <typename T>
+class ArrayView
+{
+public:
+    ArrayView(const T* data, uint32 size)
+    {
+        m_data = data;
+        m_size = size;
+    }
+
+    const T* begin() const { return m_data; }
+    const T* end() const { return m_data + m_size; }
+
+    uint32 size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    const T& operator[](uint32 index) const { return m_data[index]; }
+
+private:
+    const T* m_data;
+    uint32 m_size;
+};
+
+#endif
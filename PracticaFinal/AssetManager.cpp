@@ -0,0 +1,153 @@
+#include "AssetManager.h"
+#include "RgbImage.h"
+#include "TextureCache.h"
+#include "ThreadPool.h"
+#include <chrono>
+
+AssetManager::AssetManager()
+{
+    m_decoder = nullptr;
+}
+
+AssetManager::~AssetManager()
+{
+    // Decodes still running own their asset, they must end before it is freed
+    delete m_decoder;
+
+    for (std::unique_ptr<Asset>& asset : m_assets)
+        delete asset->image;
+}
+
+uint32 AssetManager::RequestTexture(const char* path)
+{
+    std::map<std::string, uint32>::const_iterator itr = m_assetsByPath.find(path);
+    if (itr != m_assetsByPath.end())
+        return itr->second;
+
+    if (!m_decoder)
+        m_decoder = new ThreadPool(ASSET_DECODE_THREADS);
+
+    Asset* asset = new Asset();
+    asset->path = path;
+    asset->image = nullptr;
+    asset->texture = 0;
+
+    uint32 index = uint32(m_assets.size());
+    m_assets.emplace_back(asset);
+    m_assetsByPath[asset->path] = index;
+
+    m_decoder->Submit([asset]() { Decode(asset); });
+    return index;
+}
+
+void AssetManager::Decode(Asset* asset)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    bool cached = asset->cache.Open(asset->path.c_str());
+    if (!cached)
+    {
+        RgbImage* image = new RgbImage();
+        if (!image->LoadImageFile(asset->path.c_str()))
+            ERROR_LOG("Failed to load texture %s\n", asset->path.c_str());
+        else if (TextureCache::Write(asset->path.c_str(), *image) && asset->cache.Open(asset->path.c_str()))
+        {
+            delete image;
+            image = nullptr;
+        }
+
+        asset->image = image;
+    }
+
+    DEBUG_LOG("Texture %s %s in %.2f ms\n", asset->path.c_str(), cached ? "mapped from cache" : "decoded",
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
+
+void AssetManager::UploadTextures()
+{
+    if (!m_decoder)
+        return;
+
+    m_decoder->Wait();
+
+    std::vector<GLuint> names;
+    for (std::unique_ptr<Asset>& asset : m_assets)
+        if (!asset->texture)
+            names.push_back(0);
+
+    if (names.empty())
+        return;
+
+    glGenTextures(GLsizei(names.size()), names.data());
+
+    // glGenerateMipmap needs 3.0 or ARB_framebuffer_object, 1.4 drivers generate them on upload
+    bool generateMipmap = GLEW_VERSION_3_0 || GLEW_ARB_framebuffer_object;
+
+    uint32 next = 0;
+    for (std::unique_ptr<Asset>& asset : m_assets)
+    {
+        if (asset->texture)
+            continue;
+
+        asset->texture = names[next++];
+        glBindTexture(GL_TEXTURE_2D, asset->texture);
+
+        if (asset->cache.IsOpen())
+        {
+            // Every level as stored in the file, nothing left for the driver to compute
+            for (uint32 level = 0; level < asset->cache.GetLevelCount(); level++)
+            {
+                int32 width, height;
+                const unsigned char* pixels = asset->cache.GetLevel(level, width, height);
+                glTexImage2D(GL_TEXTURE_2D, level, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+            }
+
+            asset->cache.Close();
+            continue;
+        }
+
+        if (!asset->image)
+            continue;
+
+        const RgbImage& image = *asset->image;
+        if (image.ImageLoaded())
+        {
+            if (!generateMipmap)
+                glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
+
+            // RgbImage rows are padded to four bytes, the default unpack alignment
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image.GetNumCols(), image.GetNumRows(), 0, GL_RGB, GL_UNSIGNED_BYTE, image.ImageData());
+
+            if (generateMipmap)
+                glGenerateMipmap(GL_TEXTURE_2D);
+        }
+
+        // The pixels live in the texture now
+        delete asset->image;
+        asset->image = nullptr;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+GLuint AssetManager::GetTexture(uint32 asset) const
+{
+    return asset < m_assets.size() ? m_assets[asset]->texture : 0;
+}
+
+void AssetManager::Release()
+{
+    delete m_decoder;
+    m_decoder = nullptr;
+
+    for (std::unique_ptr<Asset>& asset : m_assets)
+    {
+        if (asset->texture)
+            glDeleteTextures(1, &asset->texture);
+
+        asset->cache.Close();
+        delete asset->image;
+        asset->image = nullptr;
+        asset->texture = 0;
+    }
+}
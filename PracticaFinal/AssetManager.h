@@ -0,0 +1,55 @@
+#ifndef ASSET_MANAGER_H
+#define ASSET_MANAGER_H
+
+#include <GL/glew.h>
+#include "Common.h"
+#include "TextureCache.h"
+#include <map>
+#include <memory>
+
+class RgbImage;
+class ThreadPool;
+
+#define ASSET_DECODE_THREADS    2
+#define INVALID_ASSET           0xFFFFFFFF
+
+// Loads the textures of the game. Files are decoded by background threads as soon as they are
+// requested, so the work overlaps with the creation of the window, and converted to the texture
+// cache with their mipmaps for the next launches. Once there is a context every texture is
+// uploaded once, straight from the mapped cache, or from the decoded image with the mipmaps
+// generated by the GPU when the cache can't be written.
+class AssetManager
+{
+public:
+    AssetManager();
+    ~AssetManager();
+
+    // Can be called before the GL context exists, the same path always gives the same asset
+    uint32 RequestTexture(const char* path);
+
+    // Waits for the pending decodes and uploads every texture not uploaded yet. Needs a context.
+    void UploadTextures();
+
+    // 0 until uploaded, the texture is empty if its file couldn't be loaded
+    GLuint GetTexture(uint32 asset) const;
+
+    // Frees the textures, the decoded images and the mapped caches
+    void Release();
+
+private:
+    struct Asset
+    {
+        std::string path;
+        TextureCache cache;
+        RgbImage* image;    // Only when there is no cache
+        GLuint texture;
+    };
+
+    static void Decode(Asset* asset);
+
+    std::vector<std::unique_ptr<Asset>> m_assets;
+    std::map<std::string, uint32> m_assetsByPath;
+    ThreadPool* m_decoder;
+};
+
+#endif
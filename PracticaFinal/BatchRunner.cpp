@@ -0,0 +1,79 @@
+#include "Common.h"
+#include "AllocationCounter.h"
+#include "Randomizer.h"
+#include "Simulation.h"
+#include "ThreadPool.h"
+#include <chrono>
+
+#define DEFAULT_BATCH_GAMES         1000
+#define DEFAULT_BATCH_SEED          1
+
+// Simulates many seeded games across all cores and reports aggregated statistics.
+// Every game writes only its own result slot, workers share nothing else.
+// Usage: PracticaFinalBatch [games] [threads] [seed] [maxSteps] [randomizerPolicy]
+int main(int argc, char** argv)
+{
+    uint32 games = argc > 1 ? uint32(strtoul(argv[1], nullptr, 10)) : DEFAULT_BATCH_GAMES;
+    uint32 threads = argc > 2 ? uint32(strtoul(argv[2], nullptr, 10)) : std::thread::hardware_concurrency();
+    uint64 seed = argc > 3 ? uint64(strtoull(argv[3], nullptr, 10)) : DEFAULT_BATCH_SEED;
+    uint64 maxSteps = argc > 4 ? uint64(strtoull(argv[4], nullptr, 10)) : DEFAULT_SIMULATION_MAX_STEPS;
+    uint8 policy = argc > 5 ? uint8(atoi(argv[5])) : uint8(DEFAULT_RANDOMIZER_POLICY);
+
+    if (!games)
+    {
+        printf("Nothing to simulate.\n");
+        return 0;
+    }
+
+    std::vector<SimulationResult> results(games);
+
+    auto start = std::chrono::steady_clock::now();
+    uint64 stolenTasks = 0;
+    uint32 usedThreads = 0;
+    {
+        ThreadPool pool(threads);
+        for (uint32 i = 0; i < games; i++)
+        {
+            SimulationResult* result = &results[i];
+            uint64 gameSeed = seed + i;
+            pool.Submit([=] { *result = RunSimulation(gameSeed, policy, maxSteps); });
+        }
+
+        pool.Wait();
+        stolenTasks = pool.GetStolenTasks();
+        usedThreads = pool.GetThreadCount();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64 totalLines = 0, totalPoints = 0, totalLevels = 0, totalSteps = 0, totalAllocations = 0;
+    const SimulationResult* best = &results[0];
+    const SimulationResult* worst = &results[0];
+    for (const SimulationResult& result : results)
+    {
+        totalLines += result.lines;
+        totalPoints += result.points;
+        totalLevels += result.level;
+        totalSteps += result.steps;
+        totalAllocations += result.allocations;
+
+        if (result.lines > best->lines)
+            best = &result;
+        if (result.lines < worst->lines)
+            worst = &result;
+    }
+
+    printf("Games: %u, threads: %u, seeds: %llu-%llu, policy: %u\n", games, usedThreads, seed, seed + games - 1, policy);
+    printf("Lines: total %llu, mean %.1f, best %u (seed %llu), worst %u (seed %llu)\n", totalLines, double(totalLines) / games,
+        best->lines, best->seed, worst->lines, worst->seed);
+    printf("Points: total %llu, mean %.1f\n", totalPoints, double(totalPoints) / games);
+    printf("Level: mean %.2f\n", double(totalLevels) / games);
+    printf("Steps: total %llu, mean %.1f\n", totalSteps, double(totalSteps) / games);
+    printf("Elapsed: %.3f s, %.1f games/s, %.0f steps/s, %llu tasks stolen\n", seconds,
+        seconds > 0.0 ? games / seconds : 0.0, seconds > 0.0 ? totalSteps / seconds : 0.0, stolenTasks);
+
+#ifdef ALLOCATION_COUNTER_ENABLED
+    printf("Heap allocations during steps: %llu\n", totalAllocations);
+#endif
+
+    return 0;
+}
@@ -2,6 +2,114 @@
 #include "Common.h"
 #include "Game.h"
 
+namespace
+{
+    // Rotation 0 of every block type, indexed by BlockType
+    constexpr int8 BLOCK_SHAPES[MAX_BLOCK_TYPE + 1][NUM_BLOCK_SUBBLOCKS][2] =
+    {
+        { { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 } },
+        { { 0, 0 }, { 1, 0 }, { 0, 1 }, { 1, 1 } },     // TYPE_CUBE
+        { {-1, 0 }, { 0, 0 }, { 1, 0 }, { 2, 0 } },     // TYPE_PRISM
+        { { 0, 0 }, { 1, 0 }, { 2, 0 }, { 2, 1 } },     // TYPE_L
+        { { 0, 0 }, { 0, 1 }, { 1, 0 }, { 2, 0 } },     // TYPE_L_INV
+        { { 0, 0 }, { 1, 0 }, { 2, 0 }, { 1, 1 } },     // TYPE_T
+        { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 2, 1 } },     // TYPE_Z
+        { { 0, 1 }, { 1, 1 }, { 1, 0 }, { 2, 0 } }      // TYPE_Z_INV
+    };
+
+    // Each rotation turns the block 90 degrees counterclockwise around its origin: (x, y) -> (-y, x)
+    constexpr int8 RotateX(int32 x, int32 y, uint32 rotation) { return rotation ? RotateX(-y, x, rotation - 1) : int8(x); }
+    constexpr int8 RotateY(int32 x, int32 y, uint32 rotation) { return rotation ? RotateY(-y, x, rotation - 1) : int8(y); }
+
+    // Cube should not rotate
+    constexpr uint32 EffectiveRotation(uint32 type, uint32 rotation) { return type == TYPE_CUBE ? 0 : rotation; }
+
+    constexpr int8 CellX(uint32 type, uint32 rotation, uint32 i)
+    {
+        return RotateX(BLOCK_SHAPES[type][i][0], BLOCK_SHAPES[type][i][1], EffectiveRotation(type, rotation));
+    }
+
+    constexpr int8 CellY(uint32 type, uint32 rotation, uint32 i)
+    {
+        return RotateY(BLOCK_SHAPES[type][i][0], BLOCK_SHAPES[type][i][1], EffectiveRotation(type, rotation));
+    }
+
+    constexpr int32 Min4(int32 a, int32 b, int32 c, int32 d)
+    {
+        return (a < b ? a : b) < (c < d ? c : d) ? (a < b ? a : b) : (c < d ? c : d);
+    }
+
+    constexpr int32 MinX(uint32 type, uint32 rotation)
+    {
+        return Min4(CellX(type, rotation, 0), CellX(type, rotation, 1), CellX(type, rotation, 2), CellX(type, rotation, 3));
+    }
+
+    constexpr int32 MinY(uint32 type, uint32 rotation)
+    {
+        return Min4(CellY(type, rotation, 0), CellY(type, rotation, 1), CellY(type, rotation, 2), CellY(type, rotation, 3));
+    }
+
+    constexpr uint32 CellBit(uint32 type, uint32 rotation, uint32 i, int32 row)
+    {
+        return CellY(type, rotation, i) - MinY(type, rotation) == row ? 1u << (CellX(type, rotation, i) - MinX(type, rotation)) : 0u;
+    }
+
+    constexpr uint32 RowMask(uint32 type, uint32 rotation, int32 row)
+    {
+        return CellBit(type, rotation, 0, row) | CellBit(type, rotation, 1, row) | CellBit(type, rotation, 2, row) | CellBit(type, rotation, 3, row);
+    }
+
+    constexpr int32 CellBottom(uint32 type, uint32 rotation, uint32 i, int32 column)
+    {
+        return CellX(type, rotation, i) - MinX(type, rotation) == column ? CellY(type, rotation, i) - MinY(type, rotation) : NUM_BLOCK_SUBBLOCKS;
+    }
+
+    constexpr int32 ColumnBottom(uint32 type, uint32 rotation, int32 column)
+    {
+        return Min4(CellBottom(type, rotation, 0, column), CellBottom(type, rotation, 1, column), CellBottom(type, rotation, 2, column), CellBottom(type, rotation, 3, column));
+    }
+
+    constexpr BlockRotation MakeRotation(uint32 type, uint32 rotation)
+    {
+        return
+        {
+            {
+                { CellX(type, rotation, 0), CellY(type, rotation, 0) },
+                { CellX(type, rotation, 1), CellY(type, rotation, 1) },
+                { CellX(type, rotation, 2), CellY(type, rotation, 2) },
+                { CellX(type, rotation, 3), CellY(type, rotation, 3) }
+            },
+            {
+                { RowMask(type, rotation, 0), RowMask(type, rotation, 1), RowMask(type, rotation, 2), RowMask(type, rotation, 3) },
+                MinX(type, rotation),
+                MinY(type, rotation),
+                { ColumnBottom(type, rotation, 0), ColumnBottom(type, rotation, 1), ColumnBottom(type, rotation, 2), ColumnBottom(type, rotation, 3) }
+            }
+        };
+    }
+
+    #define BLOCK_ROTATIONS(type) { MakeRotation(type, 0), MakeRotation(type, 1), MakeRotation(type, 2), MakeRotation(type, 3) }
+
+    constexpr BlockRotation BLOCK_ROTATION_TABLE[MAX_BLOCK_TYPE + 1][NUM_BLOCK_ROTATIONS] =
+    {
+        BLOCK_ROTATIONS(0),
+        BLOCK_ROTATIONS(TYPE_CUBE),
+        BLOCK_ROTATIONS(TYPE_PRISM),
+        BLOCK_ROTATIONS(TYPE_L),
+        BLOCK_ROTATIONS(TYPE_L_INV),
+        BLOCK_ROTATIONS(TYPE_T),
+        BLOCK_ROTATIONS(TYPE_Z),
+        BLOCK_ROTATIONS(TYPE_Z_INV)
+    };
+
+    #undef BLOCK_ROTATIONS
+
+    static_assert(BLOCK_ROTATION_TABLE[TYPE_PRISM][1].mask.rows[3] == 1u, "Vertical prism should fill four rows");
+    static_assert(BLOCK_ROTATION_TABLE[TYPE_CUBE][3].mask.rows[0] == 3u, "Cube should not rotate");
+    static_assert(BLOCK_ROTATION_TABLE[TYPE_T][2].mask.bottoms[0] == 1 && BLOCK_ROTATION_TABLE[TYPE_T][2].mask.bottoms[1] == 0
+        && BLOCK_ROTATION_TABLE[TYPE_T][2].mask.bottoms[3] == NUM_BLOCK_SUBBLOCKS, "T pointing down should rest on its stem");
+}
+
 SubBlock::SubBlock()
 {
     ID = 0;
@@ -20,207 +128,86 @@ SubBlock::~SubBlock()
 {
 }
 
-void SubBlock::Delete()
-{
-    m_game->DeleteSubBlock(this);
-}
-
-bool SubBlock::CanDropSubBlock()
-{
-    if (m_position.y <= 0.0f)
-    {
-        DEBUG_LOG("Block %d hit, can't be dropped (<0).\n", ID);
-        return false;
-    }
-
-    if (SubBlock* temp = m_game->GetSubBlockInPosition(m_position.x, m_position.y - 1.0f))
-    {
-        DEBUG_LOG("Block %d hits with block %d\n", ID, temp->GetID());
-        return false;
-    }
-
-    return true;
-}
-
-Block::Block(uint8 type, Game* game, float x, float y)
+Block::Block(uint8 type, Game* game, Position position)
 {
     m_type = type;
+    m_rotation = 0;
     m_game = game;
-    m_position.x = x;
-    m_position.y = y;
-    m_subBlocks.clear();
+    m_position = position;
     GenerateSubBlocks();
 }
 
 Block::~Block()
 {
-    m_subBlocks.clear();
+    for (uint8 i = 0; i < NUM_BLOCK_SUBBLOCKS; i++)
+        m_game->DestroySubBlock(m_subBlocks[i]);
 }
 
 void Block::GenerateSubBlocks()
 {
-    uint32 currentID = m_game->GetCurrentBlockID();
-
     // Always have 4 subBlocks
-    Position* positions = Block::GetPositionsOfType(m_type);
+    const BlockRotation& rotation = Block::GetRotationOfType(m_type, m_rotation);
+    SetColor(Block::GetColorByType(m_type));
     for (uint8 i = 0; i < NUM_BLOCK_SUBBLOCKS; i++)
     {
-        SubBlock* sub = new SubBlock(m_game);
-        Position pos = positions[i];
-        SetColor(Block::GetColorByType(m_type));
+        SubBlock* sub = m_game->CreateSubBlock();
+        Position pos(rotation.cells[i].x, rotation.cells[i].y);
         sub->SetColor(Block::GetColorByType(m_type));
         sub->SetPosition(pos);
-        m_subBlocks.push_back(sub);
+        m_subBlocks[i] = sub;
 
-        DEBUG_LOG("SubBlock ID: %u created in position X: %f, Y: %f\n", sub->GetID(), pos.x, pos.y);
+        DEBUG_LOG("SubBlock ID: %u created in position X: %d, Y: %d\n", sub->GetID(), pos.x, pos.y);
     }
 }
 
+const BlockRotation& Block::GetRotationOfType(uint8 type, uint8 rotation)
+{
+    if (type > MAX_BLOCK_TYPE)
+        type = 0;
+
+    return BLOCK_ROTATION_TABLE[type][rotation % NUM_BLOCK_ROTATIONS];
+}
+
 bool Block::CanRotateBlock()
 {
     // Cube should not rotate
     if (m_type == TYPE_CUBE)
         return false;
 
-    for (SubBlock* sub : m_subBlocks)
-    {
-        float oldPosX = sub->GetPositionX();
-        float oldPosY = sub->GetPositionY();
-        float newPosX = roundf(oldPosX * cosf(float(M_PI_2)) - oldPosY * sinf(float(M_PI_2)));
-        float newPosY = roundf(oldPosX * sinf(float(M_PI_2)) + oldPosY * cosf(float(M_PI_2)));
-
-        if (m_position.x + newPosX < 0.0f || m_position.x + newPosX > MAX_WIDTH - 1.0f)
-            return false;
-
-        if (m_position.y + newPosY < 0.0f)
-            return false;
-
-        if (m_game->GetSubBlockInPosition(m_position.x + newPosX, m_position.y + newPosY))
-            return false;
-    }
-    return true;
+    const BlockMask& mask = Block::GetRotationOfType(m_type, m_rotation + 1).mask;
+    return !m_game->GetBoard().Collides(mask, m_position.x, m_position.y);
 }
 
-
 void Block::RotateBlock()
 {
     if (!CanRotateBlock())
         return;
 
-    for(SubBlock* sub : m_subBlocks)
-    {
-        float oldPosX = sub->GetPositionX();
-        float oldPosY = sub->GetPositionY();
-        float newPosX = roundf(oldPosX * cos(float(M_PI_2)) - oldPosY * sin(float(M_PI_2)));
-        float newPosY = roundf(oldPosX * sin(float(M_PI_2)) + oldPosY * cos(float(M_PI_2)));
-
-        sub->SetPositionX(newPosX);
-        sub->SetPositionY(newPosY);
-
-        DEBUG_LOG("SubBlock OldPosition: (%f, %f), newPosition: (%f, %f)\n", oldPosX, oldPosY, sub->GetPositionX(), sub->GetPositionY());
-    }
+    ApplyRotation((m_rotation + 1) % NUM_BLOCK_ROTATIONS);
 }
 
-Position* Block::GetPositionsOfType(uint8 type)
+void Block::ApplyRotation(uint8 rotation)
 {
-    static Position positions[NUM_BLOCK_SUBBLOCKS];
-    switch(type)
+    const BlockRotation& cells = Block::GetRotationOfType(m_type, rotation);
+    for (uint8 i = 0; i < NUM_BLOCK_SUBBLOCKS; i++)
     {
-        case TYPE_CUBE:
-            positions[0] = {0.0f, 0.0f};
-            positions[1] = {1.0f, 0.0f};
-            positions[2] = {0.0f, 1.0f};
-            positions[3] = {1.0f, 1.0f};
-            break;
-        case TYPE_PRISM:
-            positions[0] = {-1.0f, 0.0f};
-            positions[1] = {0.0f, 0.0f};
-            positions[2] = {1.0f, 0.0f};
-            positions[3] = {2.0f, 0.0f};
-            break;
-        case TYPE_T:
-            positions[0] = {0.0f, 0.0f};
-            positions[1] = {1.0f, 0.0f};
-            positions[2] = {2.0f, 0.0f};
-            positions[3] = {1.0f, 1.0f};
-            break;
-        case TYPE_Z:
-            positions[0] = {0.0f, 0.0f};
-            positions[1] = {1.0f, 0.0f};
-            positions[2] = {1.0f, 1.0f};
-            positions[3] = {2.0f, 1.0f};
-            break;
-        case TYPE_L:
-            positions[0] = {0.0f, 0.0f};
-            positions[1] = {1.0f, 0.0f};
-            positions[2] = {2.0f, 0.0f};
-            positions[3] = {2.0f, 1.0f};
-            break;
-        case TYPE_Z_INV:
-            positions[0] = {0.0f, 1.0f};
-            positions[1] = {1.0f, 1.0f};
-            positions[2] = {1.0f, 0.0f};
-            positions[3] = {2.0f, 0.0f};
-            break;
-        case TYPE_L_INV:
-            positions[0] = {0.0f, 0.0f};
-            positions[1] = {0.0f, 1.0f};
-            positions[2] = {1.0f, 0.0f};
-            positions[3] = {2.0f, 0.0f};
-            break;
-        default:
-            break;
+        m_subBlocks[i]->SetPosition(Position(cells.cells[i].x, cells.cells[i].y));
     }
 
-    return positions;
+    m_rotation = rotation;
 }
 
 void Block::Drop()
 {
-    bool found = false;
-
-    float posY = m_position.y;
-    for (posY; posY > 0.0f; posY -= 1.0f)
-    {
-        if (found)
-            break;
-
-        for (SubBlock* sub : GetSubBlocks())
-        {
-            if (posY + sub->GetPositionY() - 1.0f <= 0.0f)
-            {
-                found = true;
-                break;
-            }
-
-            if (SubBlock* temp = m_game->GetSubBlockInPosition(m_position.x + sub->GetPositionX(), posY + sub->GetPositionY() - 2.0f))
-            {
-                found = true;
-                DEBUG_LOG("Block %d hits with block %d\n", sub->GetID(), temp->GetID());
-                break;
-            }
-        }
-    }
-
-    if (m_position.y != posY)
-        m_position.y = posY;
+    m_position.y = int8(m_game->GetBoard().GetDropY(GetMask(), m_position.x, m_position.y));
 }
 
 bool Block::CanDropBlock()
 {
-    for (SubBlock* sub : GetSubBlocks())
+    if (m_game->GetBoard().Collides(GetMask(), m_position.x, m_position.y - 1))
     {
-        if (m_position.y + sub->GetPositionY() <= 0.0f)
-        {
-            DEBUG_LOG("Block %d hits can't be dropped (<0).\n", sub->GetID());
-            return false;
-        }
-
-        if (SubBlock* temp = m_game->GetSubBlockInPosition(m_position.x + sub->GetPositionX(), m_position.y + sub->GetPositionY() - 1.0f))
-        {
-            DEBUG_LOG("Block %d hits with block %d\n", sub->GetID(), temp->GetID());
-            return false;
-        }
+        DEBUG_LOG("Block type %d can't be dropped.\n", m_type);
+        return false;
     }
 
     return true;
@@ -228,32 +215,7 @@ bool Block::CanDropBlock()
 
 bool Block::CanMoveBlock(bool right)
 {
-    for (SubBlock* sub : m_subBlocks)
-    {
-        if (right)
-        {
-            if (m_position.x + sub->GetPositionX() >= MAX_WIDTH - 1)
-                return false;
-
-            if (SubBlock* temp = m_game->GetSubBlockInPosition(m_position.x + sub->GetPositionX() + 1, m_position.y + sub->GetPositionY()))
-            {
-                DEBUG_LOG("Block %d hits with block %d\n", sub->GetID(), temp->GetID());
-                return false;
-            }
-        }
-        else
-        {
-            if (m_position.x + sub->GetPositionX() <= 0.0f)
-                return false;
-
-            if (SubBlock* temp = m_game->GetSubBlockInPosition(m_position.x + sub->GetPositionX() - 1, m_position.y + sub->GetPositionY()))
-            {
-                DEBUG_LOG("Block %d hits with block %d\n", sub->GetID(), temp->GetID());
-                return false;
-            }
-        }
-    }
-    return true;
+    return !m_game->GetBoard().Collides(GetMask(), m_position.x + (right ? 1 : -1), m_position.y);
 }
 
 void Block::MoveBlock(bool right)
@@ -261,7 +223,29 @@ void Block::MoveBlock(bool right)
     if (!CanMoveBlock(right))
         return;
 
-    m_position.x += right ? 1.0f : -1.0f;
+    m_position.x += right ? 1 : -1;
+}
+
+const float* Block::GetColorValue(uint8 color)
+{
+    static const float COLOR_VALUES[MAX_COLOR + 1][3] =
+    {
+        { 1.000f, 1.000f, 1.000f }, // COLOR_WHITE
+        { 0.000f, 0.000f, 0.000f }, // COLOR_BLACK
+        { 0.863f, 0.078f, 0.235f }, // COLOR_RED
+        { 0.118f, 0.565f, 1.000f }, // COLOR_BLUE
+        { 0.235f, 0.702f, 0.443f }, // COLOR_GREEN
+        { 1.000f, 1.000f, 0.000f }, // COLOR_YELLOW
+        { 0.902f, 0.902f, 0.980f }, // COLOR_CYAN
+        { 1.000f, 0.000f, 0.500f }, // COLOR_PINK
+        { 1.000f, 0.500f, 0.000f }, // COLOR_ORANGE
+        { 0.653f, 0.653f, 0.653f }  // COLOR_GRAY
+    };
+
+    if (color > MAX_COLOR)
+        color = COLOR_WHITE;
+
+    return COLOR_VALUES[color];
 }
 
 uint8 Block::GetColorByType(uint8 type)
@@ -298,11 +282,11 @@ uint8 Block::GetColorByType(uint8 type)
 
 void SubBlock::DebugPosition()
 {
-    DEBUG_LOG("Block %u, Position [%f, %f, %f]\n", ID, m_position.x, m_position.y, m_position.z);
+    DEBUG_LOG("Block %u, Position [%d, %d]\n", ID, m_position.x, m_position.y);
 }
 
 void Block::DebugPosition()
 {
-    for (SubBlock* sub : m_subBlocks)
-        DEBUG_LOG("Block %u (ActiveBlock), Position [%f, %f, %f]\n", sub->GetID(), m_position.x + sub->GetPositionX(), m_position.y + sub->GetPositionY(), m_position.z + sub->GetPositionZ());
+    for (SubBlock* sub : GetSubBlocks())
+        DEBUG_LOG("Block %u (ActiveBlock), Position [%d, %d]\n", sub->GetID(), m_position.x + sub->GetPositionX(), m_position.y + sub->GetPositionY());
 }
@@ -2,6 +2,8 @@
 #define BLOCK_H
 
 #include "Common.h"
+#include "ArrayView.h"
+#include "Board.h"
 
 enum Color
 {
@@ -14,7 +16,8 @@ enum Color
     COLOR_CYAN,
     COLOR_PINK,
     COLOR_ORANGE,
-    COLOR_GRAY
+    COLOR_GRAY,
+    MAX_COLOR = COLOR_GRAY
 };
     
 enum BlockType
@@ -29,15 +32,30 @@ enum BlockType
     MAX_BLOCK_TYPE = TYPE_Z_INV
 };
 
+#define NUM_BLOCK_ROTATIONS 4
+
+struct CellOffset
+{
+    int8 x, y;
+};
+
+// One rotation state of a block type: the offsets of its subBlocks and their row masks
+struct BlockRotation
+{
+    CellOffset cells[NUM_BLOCK_SUBBLOCKS];
+    BlockMask mask;
+};
+
+// Cell of the board grid, converted to floats only when drawn
 struct Position
 {
-    Position() { x = 0.0f; y = 0.0f; z = 0.0f; }
-    Position(float _x, float _y) { x = _x; y = _y; z = 0.0f; }
-    Position(float _x, float _y, float _z) { x = _x; y = _y; z = _z; }
+    Position() { x = 0; y = 0; }
+    Position(int32 _x, int32 _y) { x = int8(_x); y = int8(_y); }
 
-    float x, y, z;
+    int8 x, y;
 
-    inline bool operator==(const Position &other) { return x == other.x && y == other.y && z == other.z; }
+    inline bool operator==(const Position &other) const { return x == other.x && y == other.y; }
+    inline bool operator!=(const Position &other) const { return !(*this == other); }
 };
 
 class Game;
@@ -50,21 +68,16 @@ public:
     SubBlock(Game* game);
     ~SubBlock();
 
-    void Delete();
-
     uint32 GetID() const { return ID; }
 
     Position GetPosition() const { return m_position; }
     void SetPosition(Position _position) { m_position = _position; }
 
-    float GetPositionX() const { return m_position.x; }
-    void SetPositionX(float x) { m_position.x = x; }
+    int32 GetPositionX() const { return m_position.x; }
+    void SetPositionX(int32 x) { m_position.x = int8(x); }
 
-    float GetPositionY() const { return m_position.y; }
-    void SetPositionY(float y) { m_position.y = y;}
-    
-    float GetPositionZ() const { return m_position.z; }
-    void SetPositionZ(float z) { m_position.z = z; }
+    int32 GetPositionY() const { return m_position.y; }
+    void SetPositionY(int32 y) { m_position.y = int8(y); }
 
     Game* GetGame() const { return m_game; }
     void SetGame(Game* game) { m_game = game; }
@@ -72,8 +85,6 @@ public:
     uint8 GetColor() const { return m_color; }
     void SetColor(uint8 color) { m_color = color; }
 
-    bool CanDropSubBlock();
-
     void DebugPosition();
 
     inline bool operator<(const SubBlock* other)
@@ -99,7 +110,7 @@ protected:
 class Block : public SubBlock
 {
 public:
-    Block(uint8 type, Game* game, float x, float y);
+    Block(uint8 type, Game* game, Position position);
     ~Block();
 
     uint8 GetType() const { return m_type; }
@@ -114,18 +125,29 @@ public:
     bool CanRotateBlock();
     bool CanMoveBlock(bool right);
 
-    static Position* GetPositionsOfType(uint8 type);
+    uint8 GetRotation() const { return m_rotation; }
+
+    static const BlockRotation& GetRotationOfType(uint8 type, uint8 rotation);
 
-    std::vector<SubBlock*> GetSubBlocks() const { return m_subBlocks; }
+    const BlockMask& GetMask() const { return GetRotationOfType(m_type, m_rotation).mask; }
+
+    ArrayView<SubBlock*> GetSubBlocks() const { return ArrayView<SubBlock*>(m_subBlocks, NUM_BLOCK_SUBBLOCKS); }
 
     static uint8 GetColorByType(uint8 type);
 
+    // Ambient and diffuse reflectance of a color as RGB
+    static const float* GetColorValue(uint8 color);
+
     void DebugPosition();
 
 private:
+    void ApplyRotation(uint8 rotation);
+
     uint8 m_type;
+    uint8 m_rotation;
 
-    std::vector<SubBlock*> m_subBlocks;
+    // Owned by the subBlock pool of the game
+    SubBlock* m_subBlocks[NUM_BLOCK_SUBBLOCKS];
 };
 
 #endif
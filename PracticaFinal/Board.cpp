@@ -0,0 +1,157 @@
+#include "Board.h"
+#include "Block.h"
+#include <climits>
+#include <cstring>
+
+Board::Board()
+{
+    Clear();
+}
+
+void Board::Clear()
+{
+    memset(m_rows, 0, sizeof(m_rows));
+    memset(m_colors, 0, sizeof(m_colors));
+    memset(m_heights, 0, sizeof(m_heights));
+    m_usedRows = 0;
+}
+
+bool Board::IsOccupied(int32 x, int32 y) const
+{
+    if (x < 0 || x >= BOARD_WIDTH || y < 0)
+        return true;
+
+    return (GetRow(y) & (1u << x)) != 0;
+}
+
+uint8 Board::GetColor(int32 x, int32 y) const
+{
+    if (x < 0 || x >= BOARD_WIDTH || y < 0 || y >= BOARD_ROWS)
+        return COLOR_WHITE;
+
+    return m_colors[y][x];
+}
+
+void Board::SetCell(int32 x, int32 y, uint8 color)
+{
+    if (x < 0 || x >= BOARD_WIDTH || y < 0 || y >= BOARD_ROWS)
+    {
+        DEBUG_LOG("Cell (%d, %d) out of the board.\n", x, y);
+        return;
+    }
+
+    m_rows[y] |= 1u << x;
+    m_colors[y][x] = (unsigned char)color;
+    m_heights[x] = int8(std::max<int32>(m_heights[x], y + 1));
+    m_usedRows = std::max(m_usedRows, y + 1);
+}
+
+uint32 Board::ClearCompletedLines()
+{
+    uint32 cleared = 0;
+    for (int32 y = 0; y < BOARD_HEIGHT; y++)
+        if (m_rows[y] == BOARD_FULL_ROW)
+            cleared |= 1u << y;
+
+    if (!cleared)
+        return 0;
+
+    // Full rows are below the highest locked cell
+    int32 dest = 0;
+    for (int32 y = 0; y < m_usedRows; y++)
+    {
+        if (cleared & (1u << y))
+            continue;
+
+        if (dest != y)
+        {
+            m_rows[dest] = m_rows[y];
+            memcpy(m_colors[dest], m_colors[y], sizeof(m_colors[0]));
+        }
+        dest++;
+    }
+
+    for (int32 y = dest; y < m_usedRows; y++)
+    {
+        m_rows[y] = 0;
+        memset(m_colors[y], 0, sizeof(m_colors[0]));
+    }
+
+    m_usedRows = dest;
+
+    // A column may lose its top cells together with the empty cells under them,
+    // so heights are found again from the top of the remaining rows
+    memset(m_heights, 0, sizeof(m_heights));
+    uint32 pending = BOARD_FULL_ROW;
+    for (int32 y = m_usedRows - 1; y >= 0 && pending; y--)
+    {
+        for (uint32 top = m_rows[y] & pending, x = 0; top; top >>= 1, x++)
+            if (top & 1u)
+                m_heights[x] = int8(y + 1);
+
+        pending &= ~m_rows[y];
+    }
+
+    return cleared;
+}
+
+bool Board::Collides(const BlockMask& mask, int32 x, int32 y) const
+{
+    // Bit 0 of the mask is the leftmost cell of the whole block
+    int32 left = x + mask.minX;
+    if (left < 0 || left >= BOARD_WIDTH)
+        return true;
+
+    for (int32 i = 0; i < NUM_BLOCK_SUBBLOCKS; i++)
+    {
+        if (!mask.rows[i])
+            continue;
+
+        int32 row = y + mask.minY + i;
+        if (row < 0)
+            return true;
+
+        uint32 shifted = mask.rows[i] << left;
+        if ((shifted & ~BOARD_FULL_ROW) || (shifted & GetRow(row)))
+            return true;
+    }
+
+    return false;
+}
+
+void Board::Lock(const BlockMask& mask, int32 x, int32 y, uint8 color)
+{
+    for (int32 i = 0; i < NUM_BLOCK_SUBBLOCKS; i++)
+        for (int32 bit = 0; bit < NUM_BLOCK_SUBBLOCKS; bit++)
+            if (mask.rows[i] & (1u << bit))
+                SetCell(x + mask.minX + bit, y + mask.minY + i, color);
+}
+
+int32 Board::GetDropY(const BlockMask& mask, int32 x, int32 y) const
+{
+    // The block rests on the highest column under it, unless part of it is already below the surface
+    int32 left = x + mask.minX;
+    int32 dropY = INT_MIN;
+    bool underSurface = false;
+    for (int32 i = 0; i < NUM_BLOCK_SUBBLOCKS; i++)
+    {
+        if (mask.bottoms[i] == NUM_BLOCK_SUBBLOCKS)
+            continue;
+
+        int32 height = GetColumnHeight(left + i);
+        int32 offset = mask.minY + mask.bottoms[i];
+        if (y + offset < height)
+            underSurface = true;
+
+        dropY = std::max(dropY, height - offset);
+    }
+
+    if (!underSurface)
+        return dropY;
+
+    // Moved under an overhang, only a cell by cell descent finds the cells above it
+    while (!Collides(mask, x, y - 1))
+        y--;
+
+    return y;
+}
@@ -0,0 +1,74 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include "Common.h"
+
+#define BOARD_WIDTH                 int32(MAX_WIDTH)
+#define BOARD_HEIGHT                int32(MAX_HEIGHT)
+#define BOARD_ROWS                  32 // Visible rows plus room for blocks locked above the top
+#define BOARD_FULL_ROW              ((1u << BOARD_WIDTH) - 1u)
+
+// Cells of a block as one bitmask per row, bit 0 being the column minX.
+// Offsets are relative to the position of the block.
+struct BlockMask
+{
+    uint32 rows[NUM_BLOCK_SUBBLOCKS];
+    int32 minX;
+    int32 minY;
+    int32 bottoms[NUM_BLOCK_SUBBLOCKS]; // Lowest row of each column of the mask, NUM_BLOCK_SUBBLOCKS if empty
+};
+
+// Locked cells as planes indexed by cell: one occupancy bitmask per row and one byte of color per cell,
+// so a traversal of the whole board reads a few hundred contiguous bytes.
+class Board
+{
+public:
+    Board();
+
+    void Clear();
+
+    // Cells outside the walls or below the floor are reported as occupied
+    bool IsOccupied(int32 x, int32 y) const;
+    uint8 GetColor(int32 x, int32 y) const;
+    void SetCell(int32 x, int32 y, uint8 color);
+
+    uint32 GetRow(int32 y) const { return (y >= 0 && y < BOARD_ROWS) ? m_rows[y] : 0; }
+
+    // Rows from the floor up to the highest locked cell
+    int32 GetUsedRows() const { return m_usedRows; }
+
+    // Rows from the floor up to the highest locked cell of the column
+    int32 GetColumnHeight(int32 x) const { return (x >= 0 && x < BOARD_WIDTH) ? m_heights[x] : BOARD_ROWS; }
+    bool IsRowFull(int32 y) const { return GetRow(y) == BOARD_FULL_ROW; }
+
+    // Removes every full visible row and compacts the rest down in one pass.
+    // Returns the cleared rows as a bitmask (bit y = row y).
+    uint32 ClearCompletedLines();
+
+    bool Collides(const BlockMask& mask, int32 x, int32 y) const;
+    void Lock(const BlockMask& mask, int32 x, int32 y, uint8 color);
+
+    // Position y where a block that doesn't collide at (x, y) lands when dropped
+    int32 GetDropY(const BlockMask& mask, int32 x, int32 y) const;
+
+    // Calls visit(x, y, color) for every locked cell, row by row from the floor
+    template <typename Visit>
+    void ForEachCell(Visit visit) const
+    {
+        for (int32 y = 0; y < m_usedRows; y++)
+        {
+            const unsigned char* colors = m_colors[y];
+            for (uint32 bits = m_rows[y], x = 0; bits; bits >>= 1, x++)
+                if (bits & 1u)
+                    visit(int32(x), y, uint8(colors[x]));
+        }
+    }
+
+private:
+    uint32 m_rows[BOARD_ROWS];
+    unsigned char m_colors[BOARD_ROWS][BOARD_WIDTH];
+    int8 m_heights[BOARD_WIDTH];
+    int32 m_usedRows;
+};
+
+#endif
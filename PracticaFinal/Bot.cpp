@@ -0,0 +1,89 @@
+#include "Bot.h"
+#include "Game.h"
+#include <climits>
+
+uint32 Bot::ChooseInputs(const Game& game)
+{
+    const Block* block = game.GetActiveBlock();
+    if (!block)
+        return INPUT_NONE;
+
+    const Board& board = game.GetBoard();
+    int32 posX = block->GetPositionX();
+    int32 posY = block->GetPositionY();
+
+    int32 bestScore = INT_MIN;
+    uint8 bestRotation = block->GetRotation();
+    int32 bestX = posX;
+
+    for (uint8 rotation = 0; rotation < NUM_BLOCK_ROTATIONS; rotation++)
+    {
+        const BlockMask& mask = Block::GetRotationOfType(block->GetType(), rotation).mask;
+        for (int32 x = -mask.minX; x + mask.minX < BOARD_WIDTH; x++)
+        {
+            if (board.Collides(mask, x, posY))
+                continue;
+
+            int32 y = board.GetDropY(mask, x, posY);
+
+            Board result = board;
+            result.Lock(mask, x, y, COLOR_WHITE);
+            int32 score = Bot::Evaluate(result, CountBits(result.ClearCompletedLines()));
+            if (score > bestScore)
+            {
+                bestScore = score;
+                bestRotation = rotation;
+                bestX = x;
+            }
+        }
+    }
+
+    uint32 inputs = INPUT_NONE;
+    if (bestRotation != block->GetRotation())
+        inputs |= INPUT_ROTATE;
+    else if (bestX < posX)
+        inputs |= INPUT_LEFT;
+    else if (bestX > posX)
+        inputs |= INPUT_RIGHT;
+    else
+        inputs |= INPUT_HARD_DROP;
+
+    return inputs;
+}
+
+int32 Bot::Evaluate(const Board& board, uint32 linesCleared)
+{
+    int32 heights[BOARD_WIDTH] = { 0 };
+    int32 holes = 0;
+
+    // From top to bottom, columns already covered by a cell turn empty cells into holes
+    uint32 covered = 0;
+    for (int32 y = BOARD_ROWS - 1; y >= 0; y--)
+    {
+        uint32 row = board.GetRow(y);
+        holes += CountBits(covered & ~row);
+
+        for (uint32 top = row & ~covered; top; top &= top - 1)
+        {
+            int32 x = 0;
+            while (!(top & (1u << x)))
+                x++;
+
+            heights[x] = y + 1;
+        }
+
+        covered |= row;
+    }
+
+    int32 aggregateHeight = 0;
+    int32 bumpiness = 0;
+    for (int32 x = 0; x < BOARD_WIDTH; x++)
+    {
+        aggregateHeight += heights[x];
+        if (x > 0)
+            bumpiness += abs(heights[x] - heights[x - 1]);
+    }
+
+    return BOT_WEIGHT_HEIGHT * aggregateHeight + BOT_WEIGHT_LINES * int32(linesCleared)
+        + BOT_WEIGHT_HOLES * holes + BOT_WEIGHT_BUMPINESS * bumpiness;
+}
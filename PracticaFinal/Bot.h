@@ -0,0 +1,24 @@
+#ifndef BOT_H
+#define BOT_H
+
+#include "Common.h"
+#include "Board.h"
+
+#define BOT_WEIGHT_HEIGHT       -51
+#define BOT_WEIGHT_LINES         76
+#define BOT_WEIGHT_HOLES        -36
+#define BOT_WEIGHT_BUMPINESS    -18
+
+class Game;
+
+// Greedy player used to drive headless games: tries every rotation and column of the
+// active block and steers it to the placement with the best board evaluation.
+class Bot
+{
+public:
+    static uint32 ChooseInputs(const Game& game);
+
+    static int32 Evaluate(const Board& board, uint32 linesCleared);
+};
+
+#endif
@@ -1,3 +1,6 @@
+#ifndef COMMON_H
+#define COMMON_H
+
 #ifdef _WIN32
 #include <Windows.h>
 #include <mmsystem.h>
@@ -34,12 +37,38 @@
 #define BYTE_SIZE                   8
 #define BUFFER_SIZE                 BYTE_SIZE * 8
 
-#define WITH_DEBUG
+// Log levels are chosen at compile time. Disabled levels only keep the call inside sizeof,
+// so the arguments are type checked but never evaluated and no code is generated.
+// Headless builds use LOG_LEVEL=LOG_LEVEL_ERROR.
+#define LOG_LEVEL_NONE              0
+#define LOG_LEVEL_ERROR             1
+#define LOG_LEVEL_INFO              2
+#define LOG_LEVEL_DEBUG             3
+
+#ifndef LOG_LEVEL
+    #ifdef _DEBUG
+        #define LOG_LEVEL           LOG_LEVEL_DEBUG
+    #else
+        #define LOG_LEVEL           LOG_LEVEL_INFO
+    #endif
+#endif
 
-#ifdef WITH_DEBUG
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+    #define ERROR_LOG(fmt, ...) fprintf(stderr, fmt, ##__VA_ARGS__)
+#else
+    #define ERROR_LOG(fmt, ...) ((void)sizeof(fprintf(stderr, fmt, ##__VA_ARGS__)))
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+    #define INFO_LOG(fmt, ...) printf(fmt, ##__VA_ARGS__)
+#else
+    #define INFO_LOG(fmt, ...) ((void)sizeof(printf(fmt, ##__VA_ARGS__)))
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
     #define DEBUG_LOG(fmt, ...) printf(fmt, ##__VA_ARGS__)
 #else
-    #define DEBUG_LOG(fmt, ...) printf("", ##__VA_ARGS__)
+    #define DEBUG_LOG(fmt, ...) ((void)sizeof(printf(fmt, ##__VA_ARGS__)))
 #endif
 
 typedef unsigned short uint8;
@@ -48,3 +77,14 @@ typedef unsigned int uint32;
 typedef signed int int32;
 typedef unsigned long long uint64;
 typedef signed long long int64;
+
+inline uint32 CountBits(uint32 value)
+{
+    uint32 count = 0;
+    for (; value; count++)
+        value &= value - 1;
+
+    return count;
+}
+
+#endif
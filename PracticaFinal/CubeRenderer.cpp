@@ -0,0 +1,279 @@
+#include "CubeRenderer.h"
+#include "Block.h"
+#include <cstddef>
+
+namespace
+{
+    // Same faces and texture coordinates as drawCube, each quad split in two triangles
+    const CubeVertex CUBE_QUADS[6][4] =
+    {
+        { { -0.5f, -0.5f,  0.5f, 0.0f, 0.0f }, {  0.5f, -0.5f,  0.5f, 1.0f, 0.0f }, {  0.5f,  0.5f,  0.5f, 1.0f, 1.0f }, { -0.5f,  0.5f,  0.5f, 0.0f, 1.0f } }, // Front
+        { { -0.5f, -0.5f, -0.5f, 1.0f, 0.0f }, { -0.5f,  0.5f, -0.5f, 1.0f, 1.0f }, {  0.5f,  0.5f, -0.5f, 0.0f, 1.0f }, {  0.5f, -0.5f, -0.5f, 0.0f, 0.0f } }, // Back
+        { { -0.5f,  0.5f, -0.5f, 0.0f, 1.0f }, { -0.5f,  0.5f,  0.5f, 0.0f, 0.0f }, {  0.5f,  0.5f,  0.5f, 1.0f, 0.0f }, {  0.5f,  0.5f, -0.5f, 1.0f, 1.0f } }, // Top
+        { { -0.5f, -0.5f, -0.5f, 1.0f, 1.0f }, {  0.5f, -0.5f, -0.5f, 0.0f, 1.0f }, {  0.5f, -0.5f,  0.5f, 0.0f, 0.0f }, { -0.5f, -0.5f,  0.5f, 1.0f, 0.0f } }, // Bottom
+        { {  0.5f, -0.5f, -0.5f, 1.0f, 0.0f }, {  0.5f,  0.5f, -0.5f, 1.0f, 1.0f }, {  0.5f,  0.5f,  0.5f, 0.0f, 1.0f }, {  0.5f, -0.5f,  0.5f, 0.0f, 0.0f } }, // Right
+        { { -0.5f, -0.5f, -0.5f, 0.0f, 0.0f }, { -0.5f, -0.5f,  0.5f, 1.0f, 0.0f }, { -0.5f,  0.5f,  0.5f, 1.0f, 1.0f }, { -0.5f,  0.5f, -0.5f, 0.0f, 1.0f } }  // Left
+    };
+
+    // The legacy cube has no normals, so every face is lit with the default normal (0, 0, 1)
+    const char* CUBE_VERTEX_SHADER =
+        "#version 120\n"
+        "attribute vec3 instanceOffset;\n"
+        "attribute vec3 instanceColor;\n"
+        "varying vec3 litColor;\n"
+        "varying vec2 texCoord;\n"
+        "void main()\n"
+        "{\n"
+        "    vec4 eyePosition = gl_ModelViewMatrix * vec4(gl_Vertex.xyz + instanceOffset, 1.0);\n"
+        "    vec3 normal = normalize(gl_NormalMatrix * vec3(0.0, 0.0, 1.0));\n"
+        "    vec3 color = gl_LightModel.ambient.rgb * instanceColor;\n"
+        "    for (int i = 0; i < 2; i++)\n"
+        "    {\n"
+        "        vec3 toLight = gl_LightSource[i].position.xyz - eyePosition.xyz;\n"
+        "        float distance = length(toLight);\n"
+        "        float attenuation = 1.0 / (gl_LightSource[i].constantAttenuation + gl_LightSource[i].linearAttenuation * distance + gl_LightSource[i].quadraticAttenuation * distance * distance);\n"
+        "        float diffuse = max(dot(normal, toLight / distance), 0.0);\n"
+        "        color += attenuation * instanceColor * (gl_LightSource[i].ambient.rgb + diffuse * gl_LightSource[i].diffuse.rgb);\n"
+        "    }\n"
+        "    litColor = min(color, 1.0);\n"
+        "    texCoord = gl_MultiTexCoord0.xy;\n"
+        "    gl_Position = gl_ProjectionMatrix * eyePosition;\n"
+        "}\n";
+
+    // GL_BLEND texture environment with the default black environment color
+    const char* CUBE_FRAGMENT_SHADER =
+        "#version 120\n"
+        "uniform sampler2D cubeTexture;\n"
+        "uniform float alpha;\n"
+        "varying vec3 litColor;\n"
+        "varying vec2 texCoord;\n"
+        "void main()\n"
+        "{\n"
+        "    vec4 texel = texture2D(cubeTexture, texCoord);\n"
+        "    gl_FragColor = vec4(litColor * (1.0 - texel.rgb), texel.a * alpha);\n"
+        "}\n";
+}
+
+CubeRenderer::CubeRenderer()
+{
+    m_program           = 0;
+    m_meshBuffer        = 0;
+    m_texture           = 0;
+    m_alphaLocation     = -1;
+}
+
+void CubeRenderer::Release()
+{
+    if (m_program)
+        glDeleteProgram(m_program);
+
+    if (m_meshBuffer)
+        glDeleteBuffers(1, &m_meshBuffer);
+
+    m_program = 0;
+    m_meshBuffer = 0;
+}
+
+bool CubeRenderer::Init(GLuint texture)
+{
+    if (!GLEW_VERSION_2_0 || !GLEW_ARB_instanced_arrays || !GLEW_ARB_draw_instanced)
+    {
+        INFO_LOG("Instanced rendering not supported, using immediate mode.\n");
+        return false;
+    }
+
+    GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, CUBE_VERTEX_SHADER);
+    GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, CUBE_FRAGMENT_SHADER);
+    if (!vertexShader || !fragmentShader)
+    {
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        return false;
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glBindAttribLocation(program, CUBE_ATTRIB_OFFSET, "instanceOffset");
+    glBindAttribLocation(program, CUBE_ATTRIB_COLOR, "instanceColor");
+    glLinkProgram(program);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked)
+    {
+        char log[BUFFER_SIZE];
+        glGetProgramInfoLog(program, BUFFER_SIZE, nullptr, log);
+        ERROR_LOG("Failed to link cube program: %s\n", log);
+        glDeleteProgram(program);
+        return false;
+    }
+
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "cubeTexture"), 0);
+    m_alphaLocation = glGetUniformLocation(program, "alpha");
+    glUseProgram(0);
+
+    CubeVertex vertices[CUBE_MESH_VERTICES];
+    BuildMesh(vertices);
+
+    glGenBuffers(1, &m_meshBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_meshBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    m_texture = texture;
+    m_program = program;
+
+    INFO_LOG("Instanced cube rendering enabled.\n");
+    return true;
+}
+
+void CubeRenderer::BuildMesh(CubeVertex vertices[CUBE_MESH_VERTICES])
+{
+    const uint8 quadToTriangles[6] = { 0, 1, 2, 0, 2, 3 };
+    for (uint8 face = 0; face < 6; face++)
+        for (uint8 i = 0; i < 6; i++)
+            vertices[face * 6 + i] = CUBE_QUADS[face][quadToTriangles[i]];
+}
+
+GLuint CubeRenderer::CompileShader(GLenum type, const char* source)
+{
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+
+    GLint compiled = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (!compiled)
+    {
+        char log[BUFFER_SIZE];
+        glGetShaderInfoLog(shader, BUFFER_SIZE, nullptr, log);
+        ERROR_LOG("Failed to compile shader: %s\n", log);
+        glDeleteShader(shader);
+        return 0;
+    }
+
+    return shader;
+}
+
+CubeBatch::CubeBatch()
+{
+    m_buffer    = 0;
+    m_capacity  = 0;
+    m_dirty     = false;
+    m_instances.reserve(CUBE_INITIAL_INSTANCES);
+}
+
+void CubeBatch::Release()
+{
+    if (m_buffer)
+        glDeleteBuffers(1, &m_buffer);
+
+    m_buffer = 0;
+    m_capacity = 0;
+    m_dirty = !m_instances.empty();
+}
+
+void CubeBatch::Clear()
+{
+    m_instances.clear();
+    m_dirty = true;
+}
+
+void CubeBatch::AddCube(GLfloat x, GLfloat y, GLfloat z, uint8 color)
+{
+    const float* rgb = Block::GetColorValue(color);
+    CubeInstance instance = { x, y, z, rgb[0], rgb[1], rgb[2] };
+    m_instances.push_back(instance);
+    m_dirty = true;
+}
+
+void CubeBatch::AddBlock(const Block* block)
+{
+    if (!block)
+        return;
+
+    AddBlock(block, block->GetPositionY());
+}
+
+void CubeBatch::AddBlock(const Block* block, int32 y)
+{
+    if (!block)
+        return;
+
+    const BlockRotation& rotation = Block::GetRotationOfType(block->GetType(), block->GetRotation());
+    for (uint8 i = 0; i < NUM_BLOCK_SUBBLOCKS; i++)
+        AddCube(GLfloat(block->GetPositionX() + rotation.cells[i].x), GLfloat(y + rotation.cells[i].y), 0.0f, block->GetColor());
+}
+
+void CubeBatch::Upload()
+{
+    if (!m_buffer)
+        glGenBuffers(1, &m_buffer);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+    if (!m_dirty)
+        return;
+
+    // Orphan the storage of the previous frame so the driver doesn't wait for it
+    GLsizeiptr size = GLsizeiptr(m_instances.size() * sizeof(CubeInstance));
+    if (size > m_capacity)
+        m_capacity = std::max<GLsizeiptr>(size * 2, CUBE_INITIAL_INSTANCES * sizeof(CubeInstance));
+
+    glBufferData(GL_ARRAY_BUFFER, m_capacity, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, size, m_instances.data());
+    m_dirty = false;
+}
+
+void CubeRenderer::Draw(CubeBatch& batch, GLfloat alpha /*=1.0f*/)
+{
+    if (!m_program || batch.m_instances.empty())
+        return;
+
+    batch.Upload();
+
+    glEnableVertexAttribArray(CUBE_ATTRIB_OFFSET);
+    glVertexAttribPointer(CUBE_ATTRIB_OFFSET, 3, GL_FLOAT, GL_FALSE, sizeof(CubeInstance), (const GLvoid*)offsetof(CubeInstance, x));
+    glVertexAttribDivisorARB(CUBE_ATTRIB_OFFSET, 1);
+
+    glEnableVertexAttribArray(CUBE_ATTRIB_COLOR);
+    glVertexAttribPointer(CUBE_ATTRIB_COLOR, 3, GL_FLOAT, GL_FALSE, sizeof(CubeInstance), (const GLvoid*)offsetof(CubeInstance, r));
+    glVertexAttribDivisorARB(CUBE_ATTRIB_COLOR, 1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_meshBuffer);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(CubeVertex), (const GLvoid*)offsetof(CubeVertex, x));
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glTexCoordPointer(2, GL_FLOAT, sizeof(CubeVertex), (const GLvoid*)offsetof(CubeVertex, u));
+
+    bool translucent = alpha < 1.0f;
+    if (translucent)
+    {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glDepthMask(GL_FALSE);
+    }
+
+    glUseProgram(m_program);
+    glUniform1f(m_alphaLocation, alpha);
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+    glDrawArraysInstancedARB(GL_TRIANGLES, 0, CUBE_MESH_VERTICES, GLsizei(batch.m_instances.size()));
+    glUseProgram(0);
+
+    if (translucent)
+    {
+        glDepthMask(GL_TRUE);
+        glDisable(GL_BLEND);
+    }
+
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glVertexAttribDivisorARB(CUBE_ATTRIB_COLOR, 0);
+    glDisableVertexAttribArray(CUBE_ATTRIB_COLOR);
+    glVertexAttribDivisorARB(CUBE_ATTRIB_OFFSET, 0);
+    glDisableVertexAttribArray(CUBE_ATTRIB_OFFSET);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
@@ -0,0 +1,89 @@
+#ifndef CUBE_RENDERER_H
+#define CUBE_RENDERER_H
+
+#include <GL/glew.h>
+#include "Common.h"
+
+#define CUBE_ATTRIB_OFFSET      6 // Generic attributes not aliased by gl_Vertex or gl_MultiTexCoord0
+#define CUBE_ATTRIB_COLOR       7
+#define CUBE_INITIAL_INSTANCES  256
+#define CUBE_MESH_VERTICES      36 // Six faces of two triangles
+
+class Block;
+
+struct CubeVertex
+{
+    GLfloat x, y, z;
+    GLfloat u, v;
+};
+
+struct CubeInstance
+{
+    GLfloat x, y, z;
+    GLfloat r, g, b;
+};
+
+// Cubes drawn together by CubeRenderer. The instance buffer is only uploaded when the batch changed,
+// so a batch filled once (static geometry) costs a single draw call per frame and no transfer.
+class CubeBatch
+{
+public:
+    CubeBatch();
+
+    void Clear();
+    void AddCube(GLfloat x, GLfloat y, GLfloat z, uint8 color);
+    void AddBlock(const Block* block);
+
+    // Cells of the block moved to row y, for the landing preview
+    void AddBlock(const Block* block, int32 y);
+
+    uint32 GetInstanceCount() const { return uint32(m_instances.size()); }
+    const std::vector<CubeInstance>& GetInstances() const { return m_instances; }
+
+    // GL objects are freed explicitly, the context may be gone when destructors run
+    void Release();
+
+private:
+    friend class CubeRenderer;
+    friend class ShaderRenderer;
+
+    void Upload();
+
+    std::vector<CubeInstance> m_instances;
+    GLuint m_buffer;
+    GLsizeiptr m_capacity;
+    bool m_dirty;
+};
+
+// Draws textured unit cubes as instances of a single mesh: the cube lives in a VBO uploaded once and
+// every cube of a batch costs one entry of its instance buffer, drawn with one call.
+// Lighting and the GL_BLEND texture environment of the fixed-function path are reproduced in a shader.
+class CubeRenderer
+{
+public:
+    CubeRenderer();
+
+    // Returns false if the driver can't draw instances, the caller keeps the immediate-mode path
+    bool Init(GLuint texture);
+    bool IsAvailable() const { return m_program != 0; }
+
+    // Batches with alpha below 1 are blended over the frame without writing depth, draw them last
+    void Draw(CubeBatch& batch, GLfloat alpha = 1.0f);
+
+    void Release();
+
+    // Unit cube centered on the origin, same faces and texture coordinates as the immediate-mode cube
+    static void BuildMesh(CubeVertex vertices[CUBE_MESH_VERTICES]);
+
+    // Returns 0 and logs the error if the source doesn't compile
+    static GLuint CompileShader(GLenum type, const char* source);
+
+private:
+
+    GLuint m_program;
+    GLuint m_meshBuffer;
+    GLuint m_texture;
+    GLint m_alphaLocation;
+};
+
+#endif
@@ -0,0 +1,168 @@
+#include "FrameCapture.h"
+#include "RgbImage.h"
+#include "ThreadPool.h"
+#include <cstring>
+
+FrameCapture::FrameCapture()
+{
+    memset(m_readbacks, 0, sizeof(m_readbacks));
+    m_nextReadback      = 0;
+    m_capturedFrames    = 0;
+    m_requested         = false;
+    m_usePixelBuffers   = false;
+    m_writer            = nullptr;
+}
+
+FrameCapture::~FrameCapture()
+{
+    // Only the writer is left here, GL objects are freed by Release
+    delete m_writer;
+}
+
+void FrameCapture::Init()
+{
+    m_usePixelBuffers = GLEW_VERSION_2_1 || GLEW_ARB_pixel_buffer_object;
+    if (m_usePixelBuffers)
+    {
+        for (Readback& readback : m_readbacks)
+            glGenBuffers(1, &readback.buffer);
+    }
+    else
+        INFO_LOG("Pixel buffer objects not supported, frames are captured synchronously.\n");
+
+    m_writer = new ThreadPool(1);
+}
+
+bool FrameCapture::IsPending() const
+{
+    if (m_requested)
+        return true;
+
+    for (const Readback& readback : m_readbacks)
+        if (readback.pending)
+            return true;
+
+    return false;
+}
+
+void FrameCapture::EndFrame()
+{
+    if (!m_writer)
+        return;
+
+    // Readbacks started on previous frames are finished by now
+    for (Readback& readback : m_readbacks)
+        if (readback.pending)
+            Collect(readback);
+
+    if (!m_requested)
+        return;
+
+    m_requested = false;
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    // Same row padding as RgbImage, so the pixels are copied as a single block
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+    if (!m_usePixelBuffers)
+    {
+        RgbImage* image = CreateImage(viewport[2], viewport[3]);
+        if (image)
+        {
+            glReadPixels(viewport[0], viewport[1], viewport[2], viewport[3], GL_RGB, GL_UNSIGNED_BYTE, image->GetRgbPixel(0, 0));
+            Write(image);
+        }
+        return;
+    }
+
+    Readback& readback = m_readbacks[m_nextReadback];
+    m_nextReadback = (m_nextReadback + 1) % CAPTURE_BUFFERS;
+
+    readback.width = viewport[2];
+    readback.height = viewport[3];
+    readback.pending = true;
+
+    // Returns as soon as the copy is queued
+    GLsizeiptr size = GLsizeiptr(((3 * readback.width + 3) & ~3) * readback.height);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+    glReadPixels(viewport[0], viewport[1], readback.width, readback.height, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void FrameCapture::Release()
+{
+    for (Readback& readback : m_readbacks)
+    {
+        if (readback.pending)
+            Collect(readback);
+
+        if (readback.buffer)
+            glDeleteBuffers(1, &readback.buffer);
+
+        readback.buffer = 0;
+    }
+
+    if (m_writer)
+        m_writer->Wait();
+
+    delete m_writer;
+    m_writer = nullptr;
+}
+
+RgbImage* FrameCapture::CreateImage(int32 width, int32 height)
+{
+    if (width <= 0 || height <= 0)
+        return nullptr;
+
+    RgbImage* image = new RgbImage(height, width);
+    if (!image->ImageLoaded())
+    {
+        delete image;
+        return nullptr;
+    }
+
+    return image;
+}
+
+void FrameCapture::Collect(Readback& readback)
+{
+    readback.pending = false;
+
+    RgbImage* image = CreateImage(readback.width, readback.height);
+    if (!image)
+        return;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    const void* pixels = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+    if (pixels)
+    {
+        memcpy(image->GetRgbPixel(0, 0), pixels, size_t(image->GetNumBytesPerRow() * image->GetNumRows()));
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if (pixels)
+        Write(image);
+    else
+    {
+        ERROR_LOG("Failed to map the captured frame.\n");
+        delete image;
+    }
+}
+
+void FrameCapture::Write(RgbImage* image)
+{
+    char filename[BUFFER_SIZE];
+    snprintf(filename, BUFFER_SIZE, CAPTURE_FILE_FORMAT, m_capturedFrames++);
+    std::string file = filename;
+
+    m_writer->Submit([image, file]()
+    {
+        if (image->WriteBmpFile(file.c_str()))
+            INFO_LOG("Frame saved to %s\n", file.c_str());
+        delete image;
+    });
+}
@@ -0,0 +1,58 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include <GL/glew.h>
+#include "Common.h"
+
+class RgbImage;
+class ThreadPool;
+
+#define CAPTURE_BUFFERS         2 // Readbacks in flight, enough to capture every frame
+#define CAPTURE_FILE_FORMAT     "captura%03u.bmp"
+
+// Saves drawn frames as numbered BMP files without stalling the frame: the back buffer is copied
+// into a pixel buffer object and only mapped on the next frame, when the GPU is done with it,
+// and the files are encoded and written by a background thread.
+class FrameCapture
+{
+public:
+    FrameCapture();
+    ~FrameCapture();
+
+    // Falls back to reading the pixels synchronously without pixel buffer objects
+    void Init();
+
+    // The next drawn frame is saved
+    void Request() { m_requested = true; }
+
+    // True while a requested frame still needs to be drawn or collected
+    bool IsPending() const;
+
+    // Called after drawing and before swapping the buffers
+    void EndFrame();
+
+    // Collects the last readbacks and waits for the files being written
+    void Release();
+
+private:
+    struct Readback
+    {
+        GLuint buffer;
+        int32 width;
+        int32 height;
+        bool pending;
+    };
+
+    RgbImage* CreateImage(int32 width, int32 height);
+    void Collect(Readback& readback);
+    void Write(RgbImage* image);
+
+    Readback m_readbacks[CAPTURE_BUFFERS];
+    uint32 m_nextReadback;
+    uint32 m_capturedFrames;
+    bool m_requested;
+    bool m_usePixelBuffers;
+    ThreadPool* m_writer;
+};
+
+#endif
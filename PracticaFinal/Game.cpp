@@ -1,36 +1,56 @@
 #include "Game.h"
+#include "TraceSink.h"
+#include <chrono>
+
+// Wall clock, clock() only counts processor time on some platforms
+static uint64 GetClockMilliseconds()
+{
+    return uint64(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
 
 Game::Game()
 {
+    m_activeBlock       = nullptr;
+    m_nextBlock         = nullptr;
     m_level             = 0;
     m_points            = 0;
     m_currentBlockId    = 0;
+    m_gameTime          = 0;
     m_nextMoveTime      = 0;
-    m_pausedTime        = 0;
+    m_lastUpdateTime    = 0;
+    m_updateAccumulator = 0;
     m_linesCompleted    = 0;
-    m_gameBlocks.clear();
+    m_gameOver          = false;
+    m_generation        = 0;
+    m_ghostY            = 0;
+    m_ghostGeneration   = ~0u;
+    m_traceSink         = nullptr;
+    m_board.Clear();
 }
 
 Game::~Game()
 {
-    m_gameBlocks.clear();
+    DestroyBlock(m_activeBlock);
+    DestroyBlock(m_nextBlock);
 }
 
-Game* Game::CreateNewGame(uint32 level /*=DEFAULT_LEVEL*/)
+Game* Game::CreateNewGame(uint32 level /*=DEFAULT_LEVEL*/, uint64 seed /*=DEFAULT_SEED*/, uint8 policy /*=DEFAULT_RANDOMIZER_POLICY*/)
 {
     Game* newGame = new Game();
     if (!newGame)
     {
-        DEBUG_LOG("Failed to create new game. Stopping...\n");
+        ERROR_LOG("Failed to create new game. Stopping...\n");
         exit(EXIT_FAILURE);
     }
 
-    DEBUG_LOG("Game succesfully created.\n");
+    INFO_LOG("Game succesfully created.\n");
 
     newGame->m_level = level;
     newGame->m_points = 0;
-    newGame->m_gameBlocks.clear();
+    newGame->m_board.Clear();
+    newGame->m_randomizer.Reset(seed, policy);
     newGame->m_nextMoveTime = newGame->GetNextMoveTime();
+    newGame->m_lastUpdateTime = GetClockMilliseconds();
 
     return newGame;
 }
@@ -43,58 +63,94 @@ void Game::StartGame()
 
 void Game::Update()
 {
-    if (int64(m_nextMoveTime - clock()) <= 0)
+    uint64 now = GetClockMilliseconds();
+    m_updateAccumulator = std::min<uint64>(m_updateAccumulator + now - m_lastUpdateTime, MAX_UPDATE_MILLISECONDS);
+    m_lastUpdateTime = now;
+
+    while (m_updateAccumulator >= STEP_MILLISECONDS)
+    {
+        Step(INPUT_NONE);
+        m_updateAccumulator -= STEP_MILLISECONDS;
+    }
+}
+
+bool Game::Step(uint32 inputs, uint32 milliseconds /*=STEP_MILLISECONDS*/)
+{
+    if (m_gameOver)
+        return false;
+
+    if (inputs & INPUT_CHANGE)
+        ChangeBlock();
+
+    if (inputs & INPUT_ROTATE)
+        RotateActiveBlock();
+
+    if (inputs & INPUT_LEFT)
+        MoveBlock(false);
+
+    if (inputs & INPUT_RIGHT)
+        MoveBlock(true);
+
+    if (inputs & INPUT_SOFT_DROP)
+        IncreaseBlockSpeed();
+
+    if (inputs & INPUT_HARD_DROP)
+        DropBlock();
+
+    // A hard drop may have ended the game, the spawned block must not fall into the board
+    if (m_gameOver)
+        return false;
+
+    m_gameTime += milliseconds;
+    if (int64(m_nextMoveTime - m_gameTime) <= 0)
     {
         //DebugBlockPositions();
         m_nextMoveTime = GetNextMoveTime();
         HandleDropBlock();
     }
+
+    return !m_gameOver;
 }
 
 void Game::PauseGame()
 {
-    //m_pausedTime = clock();
 }
 
 void Game::ResumeGame()
 {
+    // Time spent paused is not counted by the logical clock
+    m_lastUpdateTime = GetClockMilliseconds();
+    m_updateAccumulator = 0;
     m_nextMoveTime = GetNextMoveTime();
 }
 
 Block* Game::GenerateBlock(bool active, int32 type /*=-1*/)
 {
     if (type < 0)
-    {
-        // Prevent generate the same block twice in a row
-        do
-        {
-            type = rand() % (MAX_BLOCK_TYPE) + 1;
-        }
-        while (type == m_lastBlockType);
-    }
+        type = m_randomizer.NextType();
 
-    float pos[2][2] = { { CENTER, MAX_HEIGHT}, { NEXT_BLOCK_X, NEXT_BLOCK_Y} }; 
+    const Position pos[2] = { Position(int32(CENTER), BOARD_HEIGHT), Position(int32(NEXT_BLOCK_X), int32(NEXT_BLOCK_Y)) };
 
-    Block* block = new Block(type, this, pos[!active][0], pos[!active][1]);
+    Block* block = m_blockPool.Acquire(uint8(type), this, pos[!active]);
     if (!block)
     {
-        DEBUG_LOG("Failed to create block. Stopping...\n");
+        ERROR_LOG("Failed to create block. Stopping...\n");
         exit(EXIT_FAILURE);
     }
 
-    m_lastBlockType = block->GetType();
     if (!active)
     {
         if (m_activeBlock)
         {
-            m_activeBlock->SetPositionX(CENTER);
-            m_activeBlock->SetPositionY(MAX_HEIGHT);
+            m_activeBlock->SetPosition(pos[0]);
         }
         m_nextBlock = block;
     }
     else
         m_activeBlock = block;
 
+    MarkChanged();
+    Trace(TRACE_SPAWN, type, active);
     DEBUG_LOG("Block type: %d succesfully created.\n", type);
     return block;
 }
@@ -103,36 +159,42 @@ void Game::DestroyActiveBlock(bool withSave /*=true*/)
 {
     if (!m_activeBlock)
     {
-        DEBUG_LOG("Failed at destroy active block.\n");
+        ERROR_LOG("Failed at destroy active block.\n");
         return;
     }
 
     if (withSave)
     {
-        for (SubBlock* sub : m_activeBlock->GetSubBlocks())
-        {
-            sub->SetPositionX(sub->GetPositionX() + m_activeBlock->GetPositionX());
-            sub->SetPositionY(sub->GetPositionY() + m_activeBlock->GetPositionY());
-            m_gameBlocks.push_back(sub);
-            sub->DebugPosition();
-        }
+        m_board.Lock(m_activeBlock->GetMask(), m_activeBlock->GetPositionX(), m_activeBlock->GetPositionY(), m_activeBlock->GetColor());
+        m_activeBlock->DebugPosition();
+        Trace(TRACE_LOCK, m_activeBlock->GetType(), m_activeBlock->GetPositionX(), m_activeBlock->GetPositionY());
 
+        DestroyBlock(m_activeBlock);
         m_activeBlock = m_nextBlock;
         GenerateBlock(false);
     }
     else
+    {
+        DestroyBlock(m_activeBlock);
         GenerateBlock(true);
+    }
+}
+
+void Game::DestroyBlock(Block* block)
+{
+    m_blockPool.Release(block);
 }
 
 void Game::HandleDropBlock()
 {
-    if (!m_activeBlock)
+    if (!m_activeBlock || m_gameOver)
         return;
 
     if (m_activeBlock->CanDropBlock())
     {
-        float posY = std::max(m_activeBlock->GetPositionY() - 1.0f, 0.0f);
+        int32 posY = std::max(m_activeBlock->GetPositionY() - 1, 0);
         m_activeBlock->SetPositionY(posY);
+        MarkChanged();
         CheckLineCompleted();
     }
     else
@@ -148,17 +210,24 @@ void Game::RotateActiveBlock()
     if (!m_activeBlock)
         return;
 
+    uint8 rotation = m_activeBlock->GetRotation();
     m_activeBlock->RotateBlock();
+
+    if (m_activeBlock->GetRotation() != rotation)
+    {
+        MarkChanged();
+        Trace(TRACE_ROTATE, m_activeBlock->GetType(), m_activeBlock->GetRotation());
+    }
 }
 
 uint64 Game::GetNextMoveTime()
 {
-    return uint64(clock() + (DEFAULT_MILLISECONDS / 2.0f) + float(DEFAULT_MILLISECONDS) * GetSpeed());
+    return uint64(m_gameTime + (DEFAULT_MILLISECONDS / 2.0f) + float(DEFAULT_MILLISECONDS) * GetSpeed());
 }
 
 float Game::GetSpeed() const
 {
-    return -1.0f * float(std::logf(float(m_level)) / std::logf(20.0f)) + 2.0f;
+    return -1.0f * float(logf(float(m_level)) / logf(20.0f)) + 2.0f;
 }
 
 void Game::MoveBlock(bool right)
@@ -166,12 +235,16 @@ void Game::MoveBlock(bool right)
     if (!m_activeBlock)
         return;
 
+    int32 x = m_activeBlock->GetPositionX();
     m_activeBlock->MoveBlock(right);
+
+    if (m_activeBlock->GetPositionX() != x)
+        MarkChanged();
 }
 
 void Game::DropBlock()
 {
-    if (!m_activeBlock)
+    if (!m_activeBlock || m_gameOver)
         return;
 
     m_activeBlock->Drop();
@@ -182,92 +255,44 @@ void Game::DropBlock()
 
 void Game::CheckLineCompleted()
 {
-    std::vector<float> linesCompleted;
-    for (uint32 y = 0; y < MAX_HEIGHT; y++)
-    {
-        uint8 i = 0;
-        for (uint32 x = 0; x < MAX_WIDTH; x++)
-        {
-            if (!GetSubBlockInPosition(float(x), float(y)))
-                break;
-
-            i++;
-        }
-
-        // Insert line completed if all X positions are filled with subblocks
-        if (i >= MAX_WIDTH)
-            linesCompleted.push_back(float(y));
-    }
-
-    if (linesCompleted.empty())
+    uint32 cleared = m_board.ClearCompletedLines();
+    if (!cleared)
         return;
 
-    DEBUG_LOG("Lines completed: ");
-    for (float i : linesCompleted)
-    {
-        for (uint32 x = 0; x < MAX_WIDTH; x++)
-        {
-            SubBlock* sub = GetSubBlockInPosition(float(x), i);
-            if (!sub)
-            {
-                DEBUG_LOG("Incorrect line completed.\n");
-                exit(EXIT_FAILURE);
-            }
-
-            sub->Delete();
-        }
-        DEBUG_LOG("[%f]", i);
-    }
-    DEBUG_LOG("\n");
+    MarkChanged();
+    Trace(TRACE_CLEAR, int32(cleared), int32(CountBits(cleared)));
 
-    m_linesCompleted += linesCompleted.size();
+    INFO_LOG("Lines completed: ");
+    for (int32 y = 0; y < BOARD_HEIGHT; y++)
+        if (cleared & (1u << y))
+            INFO_LOG("[%d]", y);
+    INFO_LOG("\n");
+
+    m_linesCompleted += CountBits(cleared);
     m_level = (m_linesCompleted / LINE_PER_DIFF) + 1;
     m_points = m_linesCompleted * 100;
-
-    std::sort(m_gameBlocks.begin(), m_gameBlocks.end());
-
-    for (SubBlock* sub : m_gameBlocks)
-    {
-        //sub->DebugPosition();
-        for (uint32 i = 0; i < linesCompleted.size(); i++)
-            if (sub->GetPositionY() >= linesCompleted[i])
-                sub->SetPositionY(sub->GetPositionY() - 1.0f);
-    }
 }
 
 void Game::CheckGameLost()
 {
     if (!m_activeBlock)
     {
-        DEBUG_LOG("Active block not found. Stopping...");
+        ERROR_LOG("Active block not found. Stopping...\n");
         exit(EXIT_FAILURE);
     }
 
-    if (GetSubBlockInPosition(CENTER, MAX_HEIGHT - 1.0f))
+    // Also lost when the new block has no room where it spawns
+    if (m_board.IsOccupied(int32(CENTER), BOARD_HEIGHT - 1) ||
+        m_board.Collides(m_activeBlock->GetMask(), m_activeBlock->GetPositionX(), m_activeBlock->GetPositionY()))
         EndGame();
 }
 
 void Game::EndGame()
 {
-    DEBUG_LOG("END");
-}
-
-SubBlock* Game::GetSubBlockInPosition(float x, float y)
-{
-    SubBlock* sub = nullptr;
-
-    std::vector<SubBlock*> subBlocks = GetSubBlockList();
-    for (auto itr = subBlocks.begin(); itr != subBlocks.end(); itr++)
-    {
-        SubBlock* temp = *(itr);
-        if (temp->GetPositionX() == x && temp->GetPositionY() == y)
-        {
-            sub = temp;
-            break;
-        }
-    }
-
-    return sub;
+    m_gameOver = true;
+    MarkChanged();
+    Trace(TRACE_GAME_OVER, int32(m_linesCompleted), int32(m_points));
+    INFO_LOG("END\n");
 }
 
 void Game::ChangeBlock()
@@ -280,22 +305,39 @@ void Game::DebugBlockPositions()
     if (m_activeBlock)
         m_activeBlock->DebugPosition();
 
-    for (SubBlock* sub : m_gameBlocks)
-    {
-        sub->DebugPosition();
-    }
-}
-
-void Game::DeleteSubBlock(SubBlock* subBlock)
-{
-    m_gameBlocks.erase(std::find(m_gameBlocks.begin(), m_gameBlocks.end(), subBlock));
+    for (int32 y = 0; y < BOARD_ROWS; y++)
+        for (int32 x = 0; x < BOARD_WIDTH; x++)
+            if (m_board.IsOccupied(x, y))
+                DEBUG_LOG("Cell (%d, %d), Color %u\n", x, y, m_board.GetColor(x, y));
 }
 
 void Game::IncreaseBlockSpeed()
 {
     if (m_activeBlock && m_activeBlock->CanDropBlock())
     {
-        m_activeBlock->SetPositionY(m_activeBlock->GetPositionY() - 1.0f);
+        m_activeBlock->SetPositionY(m_activeBlock->GetPositionY() - 1);
         m_nextMoveTime = GetNextMoveTime();
+        MarkChanged();
     }
 }
+
+int32 Game::GetGhostY() const
+{
+    if (!m_activeBlock)
+        return 0;
+
+    // Every move, rotation, spawn, lock and line clear marks the game as changed
+    if (m_ghostGeneration != m_generation)
+    {
+        m_ghostY = m_board.GetDropY(m_activeBlock->GetMask(), m_activeBlock->GetPositionX(), m_activeBlock->GetPositionY());
+        m_ghostGeneration = m_generation;
+    }
+
+    return m_ghostY;
+}
+
+void Game::Trace(uint32 type, int32 a /*=0*/, int32 b /*=0*/, int32 c /*=0*/)
+{
+    if (m_traceSink)
+        m_traceSink->Record(type, m_gameTime, a, b, c);
+}
@@ -3,10 +3,29 @@
 
 #include "Common.h"
 #include "Block.h"
+#include "Board.h"
+#include "Randomizer.h"
+#include "Pool.h"
 
 
+class TraceSink;
+
 #define DEFAULT_LEVEL 1
 #define DEFAULT_MILLISECONDS 500
+#define STEP_MILLISECONDS 10
+#define MAX_UPDATE_MILLISECONDS 250 // Wall time caught up per Update after a stall
+
+// Inputs applied by Game::Step, can be combined
+enum GameInput
+{
+    INPUT_NONE          = 0x00,
+    INPUT_LEFT          = 0x01,
+    INPUT_RIGHT         = 0x02,
+    INPUT_ROTATE        = 0x04,
+    INPUT_SOFT_DROP     = 0x08,
+    INPUT_HARD_DROP     = 0x10,
+    INPUT_CHANGE        = 0x20
+};
 
 class Game
 {
@@ -14,10 +33,16 @@ public:
     Game();
     ~Game();
 
-    static Game* CreateNewGame(uint32 level = DEFAULT_LEVEL);
+    static Game* CreateNewGame(uint32 level = DEFAULT_LEVEL, uint64 seed = DEFAULT_SEED, uint8 policy = DEFAULT_RANDOMIZER_POLICY);
 
     void StartGame();
+
+    // Advances the game by the wall time elapsed since the last call, in fixed steps
     void Update();
+
+    // Applies the inputs and advances the logical clock, independent from the wall clock.
+    // Returns false once the game is over.
+    bool Step(uint32 inputs, uint32 milliseconds = STEP_MILLISECONDS);
     void EndGame();
     void PauseGame();
     void ResumeGame();
@@ -25,6 +50,11 @@ public:
     Block* GenerateBlock(bool active, int32 type = -1);
 
     void DestroyActiveBlock(bool withSave = true);
+    void DestroyBlock(Block* block);
+
+    // Block storage is recycled, so steady play does not allocate
+    SubBlock* CreateSubBlock() { return m_subBlockPool.Acquire(this); }
+    void DestroySubBlock(SubBlock* sub) { m_subBlockPool.Release(sub); }
 
     uint64 GetNextMoveTime();
 
@@ -34,7 +64,6 @@ public:
     void DropBlock();
     void HandleDropBlock();
     void ChangeBlock();
-    void DeleteSubBlock(SubBlock* subBlock);
     void IncreaseBlockSpeed();
 
     void DebugBlockPositions();
@@ -42,15 +71,19 @@ public:
     void CheckLineCompleted();
     void CheckGameLost();
 
-    SubBlock* GetSubBlockInPosition(float x, float y);
-    
-    std::vector<SubBlock*> GetSubBlockList() const { return m_gameBlocks; }
+    const Board& GetBoard() const { return m_board; }
+    const Randomizer& GetRandomizer() const { return m_randomizer; }
+
+    uint64 GetGameTime() const { return m_gameTime; }
+    bool IsGameOver() const { return m_gameOver; }
+
+    uint32 GetLinesCompleted() const { return m_linesCompleted; }
 
     uint32 GetPoints() const { return m_points; }
-    void SetPoints(uint32 _points) { m_points = _points; }
+    void SetPoints(uint32 _points) { m_points = _points; MarkChanged(); }
 
     uint32 GetLevel() const { return m_level; }
-    void SetLevel(uint32 _level) { m_level = std::max<int32>(1, _level); }
+    void SetLevel(uint32 _level) { m_level = std::max<int32>(1, _level); MarkChanged(); }
 
     uint32 GetCurrentBlockID() { return m_currentBlockId; }
     void SetCurrentBlockID(uint32 _currentBlockId) { m_currentBlockId = _currentBlockId; }
@@ -60,27 +93,53 @@ public:
     const Block* GetActiveBlock() const { return m_activeBlock; }
 
     void SetActiveBlock(Block* block) { m_activeBlock = block; }
+
+    // Row where the active block lands if dropped. Only computed again after the
+    // active block or the board changed, so it can be asked for every frame.
+    int32 GetGhostY() const;
     
     Block* GetNextBlock() { return m_nextBlock; }
     const Block* GetNextBlock() const { return m_nextBlock; }
 
     void SetNextBlock(Block* block) { m_nextBlock = block; }
 
+    // Optional binary event recorder, not owned by the game
+    void SetTraceSink(TraceSink* sink) { m_traceSink = sink; }
+
     float GetSpeed() const;
 
+    // Incremented on every visible state change, renderers compare it to skip unchanged frames
+    uint32 GetGeneration() const { return m_generation; }
+
 private:
+    void MarkChanged() { m_generation++; }
+    void Trace(uint32 type, int32 a = 0, int32 b = 0, int32 c = 0);
+
     Block* m_activeBlock;
     Block* m_nextBlock;
-    std::vector<SubBlock*> m_gameBlocks;
+    Pool<Block> m_blockPool;
+    Pool<SubBlock> m_subBlockPool;
+    Board m_board;
+    Randomizer m_randomizer;
     uint32 m_points;
     uint32 m_level;
     uint32 m_linesCompleted;
     uint32 m_currentBlockId;
 
+    uint64 m_gameTime;
     uint64 m_nextMoveTime;
-    uint64 m_pausedTime;
+    uint64 m_lastUpdateTime;
+    uint64 m_updateAccumulator;
+
+    bool m_gameOver;
+
+    uint32 m_generation;
+
+    // Landing row of the active block and the generation it was computed for
+    mutable int32 m_ghostY;
+    mutable uint32 m_ghostGeneration;
 
-    uint8 m_lastBlockType;
+    TraceSink* m_traceSink;
 };
 
 #endif
@@ -0,0 +1,72 @@
+#include "Common.h"
+#include "AllocationCounter.h"
+#include "Randomizer.h"
+#include "Simulation.h"
+#include "SoftwareRenderer.h"
+#include "TraceSink.h"
+#include <chrono>
+#include <cstring>
+
+#define DEFAULT_HEADLESS_GAMES      100
+#define DEFAULT_HEADLESS_SEED       1
+
+// Writes the final board of a game as <prefix><seed>.bmp
+void writeSnapshot(const Game& game, const SimulationResult& result, void* context)
+{
+    const char* prefix = (const char*)context;
+    std::string filename = std::string(prefix) + std::to_string(result.seed) + ".bmp";
+
+    SoftwareRenderer renderer;
+    if (!renderer.WriteBmpFile(game, filename.c_str()))
+        ERROR_LOG("Failed to write snapshot %s\n", filename.c_str());
+}
+
+// Runs games without window nor wall clock, driven by the bot through Game::Step.
+// Usage: PracticaFinalHeadless [games] [seed] [maxSteps] [randomizerPolicy] [traceFile|-] [imagePrefix]
+int main(int argc, char** argv)
+{
+    uint32 games = argc > 1 ? uint32(strtoul(argv[1], nullptr, 10)) : DEFAULT_HEADLESS_GAMES;
+    uint64 seed = argc > 2 ? uint64(strtoull(argv[2], nullptr, 10)) : DEFAULT_HEADLESS_SEED;
+    uint64 maxSteps = argc > 3 ? uint64(strtoull(argv[3], nullptr, 10)) : DEFAULT_SIMULATION_MAX_STEPS;
+    uint8 policy = argc > 4 ? uint8(atoi(argv[4])) : uint8(DEFAULT_RANDOMIZER_POLICY);
+
+    TraceSink* trace = argc > 5 && strcmp(argv[5], "-") != 0 ? new TraceSink(argv[5]) : nullptr;
+    char* imagePrefix = argc > 6 ? argv[6] : nullptr;
+
+    uint64 totalLines = 0;
+    uint64 totalPoints = 0;
+    uint64 totalSteps = 0;
+    uint64 totalAllocations = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint32 i = 0; i < games; i++)
+    {
+        SimulationResult result = RunSimulation(seed + i, policy, maxSteps, trace, imagePrefix ? writeSnapshot : nullptr, imagePrefix);
+
+        printf("Game %u: lines %u, points %u, level %u, steps %llu, time %llu ms\n", i, result.lines,
+            result.points, result.level, result.steps, result.gameTime);
+
+        totalLines += result.lines;
+        totalPoints += result.points;
+        totalSteps += result.steps;
+        totalAllocations += result.allocations;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (trace)
+    {
+        printf("Trace events: %llu recorded, %llu dropped\n", trace->GetRecordedEvents(), trace->GetDroppedEvents());
+        delete trace;
+    }
+
+    printf("Games: %u, lines: %llu, points: %llu, steps: %llu\n", games, totalLines, totalPoints, totalSteps);
+    printf("Elapsed: %.3f s, %.1f games/s\n", seconds, seconds > 0.0 ? games / seconds : 0.0);
+
+#ifdef ALLOCATION_COUNTER_ENABLED
+    printf("Heap allocations during steps: %llu\n", totalAllocations);
+#endif
+
+    return 0;
+}
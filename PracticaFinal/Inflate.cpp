@@ -0,0 +1,338 @@
+#include "Inflate.h"
+#include <cstring>
+
+#define INFLATE_MAX_BITS            15
+#define INFLATE_MAX_LITERAL_CODES   288
+#define INFLATE_MAX_DISTANCE_CODES  30
+#define INFLATE_END_OF_BLOCK        256
+
+namespace
+{
+    const uint32 LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    const uint32 LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    const uint32 DISTANCE_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    const uint32 DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+    const uint32 CODE_LENGTH_ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+    // Canonical Huffman code: number of codes of each length and the symbols sorted by code
+    struct Huffman
+    {
+        uint32 counts[INFLATE_MAX_BITS + 1];
+        uint32 symbols[INFLATE_MAX_LITERAL_CODES];
+    };
+
+    // Incomplete codes are accepted, over-subscribed ones are not
+    bool BuildHuffman(Huffman& huffman, const unsigned char* lengths, uint32 count)
+    {
+        memset(huffman.counts, 0, sizeof(huffman.counts));
+        for (uint32 symbol = 0; symbol < count; symbol++)
+            huffman.counts[lengths[symbol]]++;
+
+        int32 left = 1;
+        for (uint32 length = 1; length <= INFLATE_MAX_BITS; length++)
+        {
+            left = (left << 1) - int32(huffman.counts[length]);
+            if (left < 0)
+                return false;
+        }
+
+        uint32 offsets[INFLATE_MAX_BITS + 1];
+        offsets[1] = 0;
+        for (uint32 length = 1; length < INFLATE_MAX_BITS; length++)
+            offsets[length + 1] = offsets[length] + huffman.counts[length];
+
+        for (uint32 symbol = 0; symbol < count; symbol++)
+            if (lengths[symbol])
+                huffman.symbols[offsets[lengths[symbol]]++] = symbol;
+
+        return true;
+    }
+
+    // Codes of the fixed Huffman blocks, built once on first use
+    struct FixedCodes
+    {
+        Huffman literals;
+        Huffman distances;
+
+        FixedCodes()
+        {
+            unsigned char lengths[INFLATE_MAX_LITERAL_CODES];
+            uint32 symbol = 0;
+            for (; symbol < 144; symbol++)
+                lengths[symbol] = 8;
+            for (; symbol < 256; symbol++)
+                lengths[symbol] = 9;
+            for (; symbol < 280; symbol++)
+                lengths[symbol] = 7;
+            for (; symbol < INFLATE_MAX_LITERAL_CODES; symbol++)
+                lengths[symbol] = 8;
+            BuildHuffman(literals, lengths, INFLATE_MAX_LITERAL_CODES);
+
+            for (symbol = 0; symbol < INFLATE_MAX_DISTANCE_CODES; symbol++)
+                lengths[symbol] = 5;
+            BuildHuffman(distances, lengths, INFLATE_MAX_DISTANCE_CODES);
+        }
+    };
+
+    class Inflater
+    {
+    public:
+        Inflater(const unsigned char* source, size_t sourceSize, unsigned char* destination, size_t destinationSize)
+            : m_source(source), m_sourceSize(sourceSize), m_sourcePos(0), m_bitBuffer(0), m_bitCount(0),
+              m_destination(destination), m_destinationSize(destinationSize), m_destinationPos(0) { }
+
+        bool Run();
+
+    private:
+        bool GetBits(uint32 count, uint32& value);
+        bool Decode(const Huffman& huffman, uint32& symbol);
+
+        bool Stored();
+        bool Fixed();
+        bool Dynamic();
+        bool Codes(const Huffman& literals, const Huffman& distances);
+
+        const unsigned char* m_source;
+        size_t m_sourceSize;
+        size_t m_sourcePos;
+        uint32 m_bitBuffer;
+        uint32 m_bitCount;
+
+        unsigned char* m_destination;
+        size_t m_destinationSize;
+        size_t m_destinationPos;
+    };
+
+    bool Inflater::GetBits(uint32 count, uint32& value)
+    {
+        while (m_bitCount < count)
+        {
+            if (m_sourcePos == m_sourceSize)
+                return false;
+
+            m_bitBuffer |= uint32(m_source[m_sourcePos++]) << m_bitCount;
+            m_bitCount += 8;
+        }
+
+        value = m_bitBuffer & ((1u << count) - 1u);
+        m_bitBuffer = count < 32 ? m_bitBuffer >> count : 0;
+        m_bitCount -= count;
+        return true;
+    }
+
+    // Codes are read one bit at a time, most significant first
+    bool Inflater::Decode(const Huffman& huffman, uint32& symbol)
+    {
+        int32 code = 0;
+        int32 first = 0;
+        int32 index = 0;
+        for (uint32 length = 1; length <= INFLATE_MAX_BITS; length++)
+        {
+            uint32 bit;
+            if (!GetBits(1, bit))
+                return false;
+
+            code |= int32(bit);
+            int32 count = int32(huffman.counts[length]);
+            if (code - first < count)
+            {
+                symbol = huffman.symbols[index + code - first];
+                return true;
+            }
+
+            index += count;
+            first = (first + count) << 1;
+            code <<= 1;
+        }
+
+        return false;
+    }
+
+    bool Inflater::Stored()
+    {
+        // Stored blocks start on a byte boundary
+        m_bitBuffer = 0;
+        m_bitCount = 0;
+
+        if (m_sourceSize - m_sourcePos < 4)
+            return false;
+
+        uint32 length = m_source[m_sourcePos] | (m_source[m_sourcePos + 1] << 8);
+        uint32 complement = m_source[m_sourcePos + 2] | (m_source[m_sourcePos + 3] << 8);
+        m_sourcePos += 4;
+
+        if (length != (~complement & 0xFFFF) || m_sourceSize - m_sourcePos < length || m_destinationSize - m_destinationPos < length)
+            return false;
+
+        memcpy(m_destination + m_destinationPos, m_source + m_sourcePos, length);
+        m_sourcePos += length;
+        m_destinationPos += length;
+        return true;
+    }
+
+    bool Inflater::Fixed()
+    {
+        // Thread safe initialization, images may be decoded by several threads
+        static const FixedCodes fixedCodes;
+        return Codes(fixedCodes.literals, fixedCodes.distances);
+    }
+
+    bool Inflater::Dynamic()
+    {
+        uint32 literalCount, distanceCount, lengthCount;
+        if (!GetBits(5, literalCount) || !GetBits(5, distanceCount) || !GetBits(4, lengthCount))
+            return false;
+
+        literalCount += 257;
+        distanceCount += 1;
+        lengthCount += 4;
+        if (literalCount > 286 || distanceCount > INFLATE_MAX_DISTANCE_CODES)
+            return false;
+
+        unsigned char lengths[INFLATE_MAX_LITERAL_CODES + INFLATE_MAX_DISTANCE_CODES];
+        memset(lengths, 0, sizeof(lengths));
+        for (uint32 i = 0; i < lengthCount; i++)
+        {
+            uint32 length;
+            if (!GetBits(3, length))
+                return false;
+            lengths[CODE_LENGTH_ORDER[i]] = (unsigned char)length;
+        }
+
+        Huffman lengthCodes;
+        if (!BuildHuffman(lengthCodes, lengths, 19))
+            return false;
+
+        // Literal and distance code lengths, run-length encoded with the code length code
+        uint32 index = 0;
+        while (index < literalCount + distanceCount)
+        {
+            uint32 symbol;
+            if (!Decode(lengthCodes, symbol))
+                return false;
+
+            if (symbol < 16)
+            {
+                lengths[index++] = (unsigned char)symbol;
+                continue;
+            }
+
+            uint32 repeat;
+            unsigned char length = 0;
+            if (symbol == 16)
+            {
+                if (index == 0 || !GetBits(2, repeat))
+                    return false;
+                length = lengths[index - 1];
+                repeat += 3;
+            }
+            else if (symbol == 17)
+            {
+                if (!GetBits(3, repeat))
+                    return false;
+                repeat += 3;
+            }
+            else
+            {
+                if (!GetBits(7, repeat))
+                    return false;
+                repeat += 11;
+            }
+
+            if (index + repeat > literalCount + distanceCount)
+                return false;
+
+            while (repeat--)
+                lengths[index++] = length;
+        }
+
+        if (lengths[INFLATE_END_OF_BLOCK] == 0)
+            return false;
+
+        Huffman literals;
+        Huffman distances;
+        if (!BuildHuffman(literals, lengths, literalCount) || !BuildHuffman(distances, lengths + literalCount, distanceCount))
+            return false;
+
+        return Codes(literals, distances);
+    }
+
+    bool Inflater::Codes(const Huffman& literals, const Huffman& distances)
+    {
+        while (true)
+        {
+            uint32 symbol;
+            if (!Decode(literals, symbol))
+                return false;
+
+            if (symbol < INFLATE_END_OF_BLOCK)
+            {
+                if (m_destinationPos == m_destinationSize)
+                    return false;
+                m_destination[m_destinationPos++] = (unsigned char)symbol;
+                continue;
+            }
+
+            if (symbol == INFLATE_END_OF_BLOCK)
+                return true;
+
+            symbol -= INFLATE_END_OF_BLOCK + 1;
+            if (symbol >= 29)
+                return false;
+
+            uint32 extra;
+            if (!GetBits(LENGTH_EXTRA[symbol], extra))
+                return false;
+            uint32 length = LENGTH_BASE[symbol] + extra;
+
+            if (!Decode(distances, symbol) || symbol >= INFLATE_MAX_DISTANCE_CODES || !GetBits(DISTANCE_EXTRA[symbol], extra))
+                return false;
+            uint32 distance = DISTANCE_BASE[symbol] + extra;
+
+            if (distance > m_destinationPos || length > m_destinationSize - m_destinationPos)
+                return false;
+
+            // Byte by byte, the copy may overlap the bytes it produces
+            unsigned char* out = m_destination + m_destinationPos;
+            const unsigned char* from = out - distance;
+            for (uint32 i = 0; i < length; i++)
+                out[i] = from[i];
+            m_destinationPos += length;
+        }
+    }
+
+    bool Inflater::Run()
+    {
+        uint32 last;
+        do
+        {
+            uint32 type;
+            if (!GetBits(1, last) || !GetBits(2, type))
+                return false;
+
+            bool ok = false;
+            switch (type)
+            {
+            case 0: ok = Stored(); break;
+            case 1: ok = Fixed(); break;
+            case 2: ok = Dynamic(); break;
+            default: break;
+            }
+
+            if (!ok)
+                return false;
+        } while (!last);
+
+        return m_destinationPos == m_destinationSize;
+    }
+}
+
+bool InflateZlib(const unsigned char* source, size_t sourceSize, unsigned char* destination, size_t destinationSize)
+{
+    // Deflate method with a window up to 32K, no preset dictionary
+    if (sourceSize < 2 || (source[0] & 0x0F) != 8 || (source[0] >> 4) > 7 || (source[1] & 0x20) || ((source[0] << 8) | source[1]) % 31 != 0)
+        return false;
+
+    Inflater inflater(source + 2, sourceSize - 2, destination, destinationSize);
+    return inflater.Run();
+}
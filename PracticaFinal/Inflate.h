@@ -0,0 +1,11 @@
+#ifndef INFLATE_H
+#define INFLATE_H
+
+#include "Common.h"
+
+// Decompresses a zlib stream (RFC 1950 header around RFC 1951 deflate data) into a buffer
+// whose size is known beforehand, as the image data of a PNG file.
+// Returns false if the stream is corrupt or doesn't fill the whole buffer.
+bool InflateZlib(const unsigned char* source, size_t sourceSize, unsigned char* destination, size_t destinationSize);
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef PANEL_H
+#define PANEL_H
+
+#include "Common.h"
+
+// Calls add(x, y) for every gray cell of the frame around the board and the next block,
+// shared by the GL renderers and the software renderer so they draw the same layout
+template <typename AddCell>
+void ForEachPanelCell(AddCell add)
+{
+    // Bottom row and side columns of the board
+    for (float x = 0.0f; x < MAX_WIDTH; x++)
+        add(x, -1.0f);
+
+    for (float y = -1.0f; y < MAX_HEIGHT - 1.0f; y++)
+    {
+        add(-1.0f, y);
+        add(MAX_WIDTH, y);
+    }
+
+    // Box around the next block
+    for (float i = 0.0f; i < DISPLAY_NEXT_BLOCK_HEIGHT; i++)
+        add(DISPLAY_NEXT_BLOCK_X, DISPLAY_NEXT_BLOCK_Y + i);
+
+    for (float i = 0.0f; i < DISPLAY_NEXT_BLOCK_HEIGHT + 1.0f; i++)
+        add(DISPLAY_NEXT_BLOCK_X + DISPLAY_NEXT_BLOCK_WITDH, DISPLAY_NEXT_BLOCK_Y + i);
+
+    for (float i = 0.0f; i < DISPLAY_NEXT_BLOCK_WITDH; i++)
+    {
+        add(DISPLAY_NEXT_BLOCK_X + i, DISPLAY_NEXT_BLOCK_Y);
+        add(DISPLAY_NEXT_BLOCK_X + i, DISPLAY_NEXT_BLOCK_Y + DISPLAY_NEXT_BLOCK_HEIGHT);
+    }
+}
+
+#endif
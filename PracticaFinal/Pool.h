@@ -0,0 +1,89 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include "Common.h"
+#include <new>
+#include <utility>
+
+#define POOL_CHUNK_SIZE 16
+
+// Fixed-size object pool: storage is allocated in chunks and recycled through a free list,
+// so once the pool has grown to the peak number of live objects it never touches the heap again.
+template <typename T, uint32 ChunkSize = POOL_CHUNK_SIZE>
+class Pool
+{
+public:
+    Pool()
+    {
+        m_freeList = nullptr;
+        m_liveObjects = 0;
+    }
+
+    ~Pool()
+    {
+        if (m_liveObjects)
+            ERROR_LOG("Pool destroyed with %u live objects.\n", m_liveObjects);
+
+        for (Slot* chunk : m_chunks)
+            delete[] chunk;
+    }
+
+    template <typename... Args>
+    T* Acquire(Args&&... args)
+    {
+        if (!m_freeList)
+            Grow();
+
+        Slot* slot = m_freeList;
+        m_freeList = slot->next;
+        m_liveObjects++;
+
+        return new (slot->storage) T(std::forward<Args>(args)...);
+    }
+
+    void Release(T* object)
+    {
+        if (!object)
+            return;
+
+        object->~T();
+
+        Slot* slot = reinterpret_cast<Slot*>(object);
+        slot->next = m_freeList;
+        m_freeList = slot;
+        m_liveObjects--;
+    }
+
+    uint32 GetLiveObjects() const { return m_liveObjects; }
+    uint32 GetCapacity() const { return uint32(m_chunks.size()) * ChunkSize; }
+
+private:
+    union Slot
+    {
+        Slot* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    void Grow()
+    {
+        Slot* chunk = new Slot[ChunkSize];
+        for (uint32 i = 0; i < ChunkSize; i++)
+        {
+            chunk[i].next = m_freeList;
+            m_freeList = &chunk[i];
+        }
+
+        m_chunks.push_back(chunk);
+        DEBUG_LOG("Pool grown to %u objects of %u bytes.\n", GetCapacity(), uint32(sizeof(T)));
+    }
+
+    // Copying would alias the chunks
+    Pool(const Pool&);
+    Pool& operator=(const Pool&);
+
+    std::vector<Slot*> m_chunks;
+    Slot* m_freeList;
+    uint32 m_liveObjects;
+};
+
+#endif
@@ -0,0 +1,129 @@
+#include "Randomizer.h"
+
+static uint64 SplitMix64(uint64& state)
+{
+    uint64 z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static inline uint64 RotateLeft(uint64 value, int32 bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+Randomizer::Randomizer(uint64 seed /*=DEFAULT_SEED*/, uint8 policy /*=DEFAULT_RANDOMIZER_POLICY*/)
+{
+    Reset(seed, policy);
+}
+
+void Randomizer::Reset(uint64 seed, uint8 policy)
+{
+    m_seed = seed;
+    m_policy = policy < MAX_RANDOMIZER_POLICY ? policy : uint8(DEFAULT_RANDOMIZER_POLICY);
+    m_lastType = 0;
+    m_bagSize = 0;
+
+    uint64 splitState = seed;
+    for (uint8 i = 0; i < 4; i++)
+        m_state[i] = SplitMix64(splitState);
+
+    // Start as if the snake blocks were just generated, hard to begin with
+    for (uint8 i = 0; i < RANDOMIZER_HISTORY_SIZE; i++)
+        m_history[i] = (i % 2) ? TYPE_Z_INV : TYPE_Z;
+}
+
+uint64 Randomizer::NextRandom()
+{
+    uint64 result = RotateLeft(m_state[1] * 5, 7) * 9;
+    uint64 t = m_state[1] << 17;
+
+    m_state[2] ^= m_state[0];
+    m_state[3] ^= m_state[1];
+    m_state[1] ^= m_state[2];
+    m_state[0] ^= m_state[3];
+    m_state[2] ^= t;
+    m_state[3] = RotateLeft(m_state[3], 45);
+
+    return result;
+}
+
+uint32 Randomizer::NextBelow(uint32 bound)
+{
+    // Multiply-shift instead of modulo, bias is negligible for small bounds
+    return uint32(((NextRandom() >> 32) * bound) >> 32);
+}
+
+uint8 Randomizer::NextType()
+{
+    uint8 type = 0;
+    switch (m_policy)
+    {
+    case RANDOMIZER_UNIFORM:
+        type = uint8(NextBelow(MAX_BLOCK_TYPE) + 1);
+        break;
+    case RANDOMIZER_NO_REPEAT:
+        if (!m_lastType)
+            type = uint8(NextBelow(MAX_BLOCK_TYPE) + 1);
+        else
+        {
+            // Pick among the other types, no need to reroll
+            type = uint8(NextBelow(MAX_BLOCK_TYPE - 1) + 1);
+            if (type >= m_lastType)
+                type++;
+        }
+        break;
+    case RANDOMIZER_BAG:
+        type = NextFromBag();
+        break;
+    case RANDOMIZER_HISTORY:
+        type = NextFromHistory();
+        break;
+    default:
+        break;
+    }
+
+    m_lastType = type;
+    return type;
+}
+
+uint8 Randomizer::NextFromBag()
+{
+    if (!m_bagSize)
+    {
+        for (uint8 i = 0; i < MAX_BLOCK_TYPE; i++)
+            m_bag[i] = i + 1;
+
+        m_bagSize = MAX_BLOCK_TYPE;
+    }
+
+    // Drawing a random element from the remaining ones is a lazy Fisher-Yates shuffle
+    uint32 index = NextBelow(m_bagSize);
+    uint8 type = m_bag[index];
+    m_bag[index] = m_bag[--m_bagSize];
+    return type;
+}
+
+uint8 Randomizer::NextFromHistory()
+{
+    uint8 type = 0;
+    for (uint8 roll = 0; roll < RANDOMIZER_HISTORY_ROLLS; roll++)
+    {
+        type = uint8(NextBelow(MAX_BLOCK_TYPE) + 1);
+
+        bool repeated = false;
+        for (uint8 i = 0; i < RANDOMIZER_HISTORY_SIZE; i++)
+            if (m_history[i] == type)
+                repeated = true;
+
+        if (!repeated)
+            break;
+    }
+
+    for (uint8 i = RANDOMIZER_HISTORY_SIZE - 1; i > 0; i--)
+        m_history[i] = m_history[i - 1];
+    m_history[0] = type;
+
+    return type;
+}
@@ -0,0 +1,54 @@
+#ifndef RANDOMIZER_H
+#define RANDOMIZER_H
+
+#include "Common.h"
+#include "Block.h"
+
+#define DEFAULT_SEED                0
+#define RANDOMIZER_HISTORY_SIZE     4
+#define RANDOMIZER_HISTORY_ROLLS    6
+
+enum RandomizerPolicy
+{
+    RANDOMIZER_UNIFORM,         // Every type with the same probability
+    RANDOMIZER_NO_REPEAT,       // Never the same type twice in a row
+    RANDOMIZER_BAG,             // Shuffled bags with one block of each type
+    RANDOMIZER_HISTORY,         // Rerolls a few times against the last types generated
+    MAX_RANDOMIZER_POLICY
+};
+
+#define DEFAULT_RANDOMIZER_POLICY   RANDOMIZER_NO_REPEAT
+
+// Block type generator owned by each game. Uses xoshiro256** seeded through splitmix64,
+// so the same seed and policy always give the same sequence without any global state.
+class Randomizer
+{
+public:
+    Randomizer(uint64 seed = DEFAULT_SEED, uint8 policy = DEFAULT_RANDOMIZER_POLICY);
+
+    void Reset(uint64 seed, uint8 policy);
+
+    uint8 NextType();
+
+    uint64 NextRandom();
+    uint32 NextBelow(uint32 bound);
+
+    uint64 GetSeed() const { return m_seed; }
+    uint8 GetPolicy() const { return m_policy; }
+
+private:
+    uint8 NextFromBag();
+    uint8 NextFromHistory();
+
+    uint64 m_state[4];
+    uint64 m_seed;
+    uint8 m_policy;
+    uint8 m_lastType;
+
+    uint8 m_bag[MAX_BLOCK_TYPE];
+    uint8 m_bagSize;
+
+    uint8 m_history[RANDOMIZER_HISTORY_SIZE];
+};
+
+#endif
@@ -0,0 +1,104 @@
+#include "RenderQueue.h"
+#include "Block.h"
+#include <cstring>
+
+RenderQueue::RenderQueue()
+{
+    m_items.reserve(RENDER_QUEUE_INITIAL_ITEMS);
+    memset(&m_stats, 0, sizeof(m_stats));
+}
+
+void RenderQueue::Submit(DrawFunction draw, GLfloat x, GLfloat y, GLfloat z, GLuint texture, uint8 blend, uint8 color)
+{
+    RenderItem item = { MakeKey(texture, blend, color), draw, x, y, z };
+    m_items.push_back(item);
+}
+
+void RenderQueue::Flush()
+{
+    memset(&m_stats, 0, sizeof(m_stats));
+    m_stats.items = uint32(m_items.size());
+    if (m_items.empty())
+        return;
+
+    // Items with the same key are interchangeable, so an in-place sort does; stable_sort would allocate every frame
+    std::sort(m_items.begin(), m_items.end(), [](const RenderItem& a, const RenderItem& b)
+    {
+        bool translucentA = IsTranslucent(a.key);
+        bool translucentB = IsTranslucent(b.key);
+        return translucentA != translucentB ? translucentB : a.key < b.key;
+    });
+
+    // Nothing is assumed about the state left by the previous code
+    bool first = true;
+    GLuint currentTexture = 0;
+    uint8 currentBlend = RENDER_BLEND_NONE;
+    uint8 currentColor = 0;
+
+    for (const RenderItem& item : m_items)
+    {
+        GLuint texture = GLuint(item.key >> 32);
+        uint8 blend = uint8((item.key >> 8) & 0xFF);
+        uint8 color = uint8(item.key & 0xFF);
+
+        // Translucent items are sorted last, blending is only turned on once
+        bool startTranslucent = blend == RENDER_BLEND_TRANSLUCENT && (first || currentBlend != RENDER_BLEND_TRANSLUCENT);
+        if (startTranslucent)
+        {
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            glDepthMask(GL_FALSE);
+            m_stats.stateCalls += 3;
+        }
+
+        if (first || blend != currentBlend)
+        {
+            if (blend == RENDER_BLEND_NONE)
+                glDisable(GL_TEXTURE_2D);
+            else
+            {
+                glEnable(GL_TEXTURE_2D);
+                glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, blend == RENDER_BLEND_REPLACE ? GL_REPLACE : GL_BLEND);
+                m_stats.stateCalls++;
+            }
+            m_stats.stateCalls++;
+        }
+
+        if (blend != RENDER_BLEND_NONE && (first || texture != currentTexture))
+        {
+            glBindTexture(GL_TEXTURE_2D, texture);
+            m_stats.stateCalls++;
+        }
+
+        if (first || color != currentColor || startTranslucent)
+        {
+            const float* rgb = Block::GetColorValue(color);
+            GLfloat alpha = blend == RENDER_BLEND_TRANSLUCENT ? RENDER_TRANSLUCENT_ALPHA : 1.0f;
+            GLfloat Kad[] = { rgb[0], rgb[1], rgb[2], alpha };
+            glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, Kad);
+            glColor4f(rgb[0], rgb[1], rgb[2], alpha);
+            m_stats.stateCalls += 2;
+        }
+
+        first = false;
+        currentTexture = texture;
+        currentBlend = blend;
+        currentColor = color;
+
+        glPushMatrix();
+        glTranslatef(item.x, item.y, item.z);
+        item.draw();
+        glPopMatrix();
+    }
+
+    glDisable(GL_TEXTURE_2D);
+    if (currentBlend == RENDER_BLEND_TRANSLUCENT)
+    {
+        glDepthMask(GL_TRUE);
+        glDisable(GL_BLEND);
+    }
+
+    uint32 naiveCalls = m_stats.items * RENDER_ITEM_STATE_CALLS;
+    m_stats.eliminatedCalls = naiveCalls > m_stats.stateCalls ? naiveCalls - m_stats.stateCalls : 0;
+    m_items.clear();
+}
@@ -0,0 +1,59 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <GL/glew.h>
+#include "Common.h"
+
+#define RENDER_QUEUE_INITIAL_ITEMS  256
+#define RENDER_ITEM_STATE_CALLS     5 // Enable, bind, texture env, material and color set by every item
+#define RENDER_TRANSLUCENT_ALPHA    0.35f
+
+// Texture environment of an item
+enum RenderBlend
+{
+    RENDER_BLEND_NONE,          // Untextured
+    RENDER_BLEND_BLEND,         // GL_BLEND, the texture darkens the material color
+    RENDER_BLEND_REPLACE,       // GL_REPLACE, only the texture is shown
+    RENDER_BLEND_TRANSLUCENT    // GL_BLEND drawn after every other item, alpha blended without writing depth
+};
+
+struct RenderQueueStats
+{
+    uint32 items;
+    uint32 stateCalls;      // State changes actually issued
+    uint32 eliminatedCalls; // State changes skipped because the state was already set
+};
+
+// Immediate-mode draw items collected for a frame and sorted by (texture, blend, color),
+// so Flush only issues the state transitions between consecutive different items.
+// Translucent items are drawn last so they blend over the rest of the frame.
+class RenderQueue
+{
+public:
+    typedef void (*DrawFunction)();
+
+    RenderQueue();
+
+    void Submit(DrawFunction draw, GLfloat x, GLfloat y, GLfloat z, GLuint texture, uint8 blend, uint8 color);
+
+    // Draws and clears the queue, texturing is left disabled
+    void Flush();
+
+    const RenderQueueStats& GetStats() const { return m_stats; }
+
+private:
+    struct RenderItem
+    {
+        uint64 key;
+        DrawFunction draw;
+        GLfloat x, y, z;
+    };
+
+    static uint64 MakeKey(GLuint texture, uint8 blend, uint8 color) { return (uint64(texture) << 32) | (uint64(blend) << 8) | color; }
+    static bool IsTranslucent(uint64 key) { return ((key >> 8) & 0xFF) == RENDER_BLEND_TRANSLUCENT; }
+
+    std::vector<RenderItem> m_items;
+    RenderQueueStats m_stats;
+};
+
+#endif
@@ -23,6 +23,13 @@
 #endif
 
 #include "RgbImage.h"
+#include <string.h>
+#include <stdlib.h>
+#include "Inflate.h"
+
+#ifdef RGBIMAGE_USE_SSSE3
+#include <tmmintrin.h>
+#endif
 
 #ifndef RGBIMAGE_DONT_USE_OPENGL
 #include <windows.h>
@@ -50,123 +57,500 @@ RgbImage::RgbImage( int numRows, int numCols )
 	}
 }
 
+/* ********************************************************************
+ *  LoadImageFile
+ *  Loads a BMP or PNG file, chosen by the signature at its start.
+ **********************************************************************/
+
+bool RgbImage::LoadImageFile( const char* filename )
+{
+	unsigned char signature[2] = { 0, 0 };
+	FILE* infile = fopen( filename, "rb" );
+	if ( infile ) {
+		if ( fread( signature, 1, 2, infile )!=2 ) {
+			signature[0] = 0;
+		}
+		fclose( infile );
+	}
+	if ( signature[0]==0x89 && signature[1]=='P' ) {
+		return LoadPngFile( filename );
+	}
+	return LoadBmpFile( filename );
+}
+
 /* ********************************************************************
  *  LoadBmpFile
- *  Read into memory an RGB image from an uncompressed BMP file.
+ *  Read into memory an RGB image from a BMP file: 24 or 32 bits per
+ *     pixel, 1, 4 or 8 bits with a palette, RLE8 and RLE4 compression,
+ *     bottom-up or top-down.  Alpha is dropped.
  *  Return true for success, false for failure.  Error code is available
  *     with a separate call.
  *  Author: Sam Buss December 2001.
+ *  The whole file is read with one call and decoded from memory.
  **********************************************************************/
 
 bool RgbImage::LoadBmpFile( const char* filename ) 
 {  
 	Reset();
-	FILE* infile = fopen( filename, "rb" );		// Open for reading binary data
-	if ( !infile ) {
-		fprintf(stderr, "Unable to open file: %s\n", filename);
-		ErrorCode = OpenError;
+	long fileSize;
+	unsigned char* fileData = readFile( filename, &fileSize );
+	if ( !fileData ) {
 		return false;
 	}
 
 	bool fileFormatOK = false;
-	int bChar = fgetc( infile );
-	int mChar = fgetc( infile );
-	if ( bChar=='B' && mChar=='M' ) {			// If starts with "BM" for "BitMap"
-		skipChars( infile, 4+2+2+4+4 );			// Skip 4 fields we don't care about
-		NumCols = readLong( infile );
-		NumRows = readLong( infile );
-		skipChars( infile, 2 );					// Skip one field
-		int bitsPerPixel = readShort( infile );
-		skipChars( infile, 4+4+4+4+4+4 );		// Skip 6 more fields
-
+	long dataOffset = 0;
+	long infoSize = 0;
+	long height = 0;
+	int bitsPerPixel = 0;
+	long compression = 0;
+	if ( fileSize>=BmpHeaderSize && fileData[0]=='B' && fileData[1]=='M' ) {	// If starts with "BM" for "BitMap"
+		dataOffset = getLong( fileData+10 );
+		infoSize = getLong( fileData+14 );
+		NumCols = getLong( fileData+18 );
+		height = getLong( fileData+22 );		// Negative for top-down
+		NumRows = height<0 ? -height : height;
+		bitsPerPixel = getShort( fileData+28 );
+		compression = getLong( fileData+30 );
+
+		bool formatOK = ( compression==BmpRgb && ( bitsPerPixel==1 || bitsPerPixel==4 || bitsPerPixel==8 
+												|| bitsPerPixel==24 || bitsPerPixel==32 ) )
+						|| ( compression==BmpRle8 && bitsPerPixel==8 && height>0 )
+						|| ( compression==BmpRle4 && bitsPerPixel==4 && height>0 )
+						|| ( compression==BmpBitFields && bitsPerPixel==32 );
 		if ( NumCols>0 && NumCols<=100000 && NumRows>0 && NumRows<=100000  
-			&& bitsPerPixel==24 && !feof(infile) ) {
-			fileFormatOK = true;
+			&& formatOK && infoSize>=40 && dataOffset>=14+infoSize && dataOffset<=fileSize ) {
+			// Reject sizes the file can't hold before allocating: uncompressed rows are stored whole,
+			//   RLE data takes at least two bytes per row or four per 255 skipped rows
+			double dataSize = (double)(fileSize-dataOffset);
+			double minDataSize = compression==BmpRgb || compression==BmpBitFields 
+									? (double)(((NumCols*bitsPerPixel+31)>>5)<<2)*NumRows : NumRows/64.0;
+			fileFormatOK = dataSize>=minDataSize;
 		}
 	}
 	if ( !fileFormatOK ) {
 		Reset();
 		ErrorCode = FileFormatError;
-		fprintf(stderr, "Not a valid 24-bit bitmap file: %s.\n", filename);
-		fclose ( infile );
+		fprintf(stderr, "Not a supported bitmap file: %s.\n", filename);
+		delete[] fileData;
 		return false;
 	}
 
-	// Allocate memory
-	ImagePtr = new unsigned char[NumRows*GetNumBytesPerRow()];
+	// Allocate memory, zeroed so padding and pixels skipped by RLE deltas are black
+	ImagePtr = new unsigned char[NumRows*GetNumBytesPerRow()]();
 	if ( !ImagePtr ) {
 		fprintf(stderr, "Unable to allocate memory for %ld x %ld bitmap: %s.\n", 
 				NumRows, NumCols, filename);
 		Reset();
 		ErrorCode = MemoryError;
-		fclose ( infile );
+		delete[] fileData;
 		return false;
 	}
 
-	unsigned char* cPtr = ImagePtr;
-	for ( int i=0; i<NumRows; i++ ) {
-		int j;
-		for ( j=0; j<NumCols; j++ ) {
-			*(cPtr+2) = fgetc( infile );	// Blue color value
-			*(cPtr+1) = fgetc( infile );	// Green color value
-			*cPtr = fgetc( infile );		// Red color value
-			cPtr += 3;
+	// Color table (blue, green, red, reserved) after the info header
+	unsigned char palette[256][3];
+	memset( palette, 0, sizeof(palette) );
+	if ( bitsPerPixel<=8 ) {
+		long numColors = getLong( fileData+46 );
+		if ( numColors<=0 || numColors>(1L<<bitsPerPixel) ) {
+			numColors = 1L<<bitsPerPixel;
 		}
-		int k=3*NumCols;					// Num bytes already read
-		for ( ; k<GetNumBytesPerRow(); k++ ) {
-			fgetc( infile );				// Read and ignore padding;
-			*(cPtr++) = 0;
+		const unsigned char* entry = fileData+14+infoSize;
+		for ( long i=0; i<numColors && entry+4<=fileData+dataOffset; i++, entry+=4 ) {
+			palette[i][0] = entry[2];
+			palette[i][1] = entry[1];
+			palette[i][2] = entry[0];
 		}
 	}
-	if ( feof( infile ) ) {
+
+	bool dataOK;
+	if ( compression==BmpRle8 || compression==BmpRle4 ) {
+		dataOK = decodeBmpRle( fileData+dataOffset, fileSize-dataOffset, bitsPerPixel, palette );
+	}
+	else {
+		// Masks follow the 40 byte info header, or are part of the larger ones
+		unsigned long masks[3] = { 0x00ff0000, 0x0000ff00, 0x000000ff };
+		if ( compression==BmpBitFields && 14+40+12<=fileSize ) {
+			for ( int c=0; c<3; c++ ) {
+				masks[c] = (unsigned long)getLong( fileData+14+40+4*c )&0xffffffffUL;
+			}
+		}
+
+		long srcRowLen = ((NumCols*bitsPerPixel+31)>>5)<<2;
+		dataOK = srcRowLen*NumRows<=fileSize-dataOffset;
+		for ( long i=0; dataOK && i<NumRows; i++ ) {
+			const unsigned char* src = fileData+dataOffset+i*srcRowLen;
+			unsigned char* cPtr = ImagePtr + (height<0 ? NumRows-1-i : i)*GetNumBytesPerRow();
+			if ( bitsPerPixel==24 ) {
+				memcpy( cPtr, src, 3*NumCols );
+				swapRedBlue( cPtr, NumCols );
+			}
+			else if ( bitsPerPixel==32 ) {
+				for ( long j=0; j<NumCols; j++, src+=4, cPtr+=3 ) {
+					unsigned long pixel = (unsigned long)getLong( src )&0xffffffffUL;
+					cPtr[0] = maskChannel( pixel, masks[0] );
+					cPtr[1] = maskChannel( pixel, masks[1] );
+					cPtr[2] = maskChannel( pixel, masks[2] );
+				}
+			}
+			else {
+				int pixelsPerByte = 8/bitsPerPixel;
+				int indexMask = (1<<bitsPerPixel)-1;
+				for ( long j=0; j<NumCols; j++, cPtr+=3 ) {
+					int shift = 8-bitsPerPixel*(1+(int)(j%pixelsPerByte));
+					memcpy( cPtr, palette[(src[j/pixelsPerByte]>>shift)&indexMask], 3 );
+				}
+			}
+		}
+	}
+	delete[] fileData;
+
+	if ( !dataOK ) {
 		fprintf( stderr, "Premature end of file: %s.\n", filename );
 		Reset();
 		ErrorCode = ReadError;
-		fclose ( infile );
 		return false;
 	}
-	fclose( infile );	// Close the file
 	return true;
 }
 
-short RgbImage::readShort( FILE* infile )
+/* ********************************************************************
+ *  decodeBmpRle
+ *  Run-length encoded 8 or 4 bit data, always bottom-up.
+ *  Return false if the data ends before the end of bitmap code.
+ **********************************************************************/
+
+bool RgbImage::decodeBmpRle( const unsigned char* data, long size, int bitsPerPixel, 
+							 const unsigned char palette[256][3] )
 {
-	// read a 16 bit integer
-	unsigned char lowByte, hiByte;
-	lowByte = fgetc(infile);			// Read the low order byte (little endian form)
-	hiByte = fgetc(infile);			// Read the high order byte
-
-	// Pack together
-	short ret = hiByte;
-	ret <<= 8;
-	ret |= lowByte;
-	return ret;
+	long x = 0;
+	long y = 0;
+	long pos = 0;
+	while ( pos+2<=size ) {
+		int count = data[pos];
+		int value = data[pos+1];
+		pos += 2;
+		if ( count>0 ) {
+			// Encoded run, 4 bit runs alternate the two indices of the byte
+			for ( int k=0; k<count; k++, x++ ) {
+				int index = bitsPerPixel==8 ? value : ( (k&1) ? value&0x0f : value>>4 );
+				if ( x<NumCols && y<NumRows ) {
+					memcpy( GetRgbPixel( y, x ), palette[index], 3 );
+				}
+			}
+		}
+		else if ( value==0 ) {			// End of line
+			x = 0;
+			y++;
+		}
+		else if ( value==1 ) {			// End of bitmap
+			return true;
+		}
+		else if ( value==2 ) {			// Delta
+			if ( pos+2>size ) {
+				return false;
+			}
+			x += data[pos];
+			y += data[pos+1];
+			pos += 2;
+		}
+		else {							// Absolute run of value pixels, padded to a word
+			long runBytes = bitsPerPixel==8 ? value : (value+1)/2;
+			if ( pos+runBytes>size ) {
+				return false;
+			}
+			for ( int k=0; k<value; k++, x++ ) {
+				int index = bitsPerPixel==8 ? data[pos+k] : ( (k&1) ? data[pos+k/2]&0x0f : data[pos+k/2]>>4 );
+				if ( x<NumCols && y<NumRows ) {
+					memcpy( GetRgbPixel( y, x ), palette[index], 3 );
+				}
+			}
+			pos += (runBytes+1)&~1L;
+		}
+	}
+	return false;
 }
 
-long RgbImage::readLong( FILE* infile )
+/* ********************************************************************
+ *  LoadPngFile
+ *  Read into memory an RGB image from a PNG file.  Every color type
+ *     and bit depth is supported, alpha is dropped and 16 bit samples
+ *     are reduced to 8 bits.  Interlaced files are not supported.
+ *  Return true for success, false for failure.  Error code is available
+ *     with a separate call.
+ **********************************************************************/
+
+bool RgbImage::LoadPngFile( const char* filename )
+{
+	static const unsigned char pngSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+
+	Reset();
+	long fileSize;
+	unsigned char* fileData = readFile( filename, &fileSize );
+	if ( !fileData ) {
+		return false;
+	}
+
+	// Walk the chunks: IHDR first, PLTE before the image data, IDAT data concatenated
+	bool fileFormatOK = fileSize>=8 && memcmp( fileData, pngSignature, 8 )==0;
+	int bitDepth = 0;
+	int colorType = 0;
+	unsigned char palette[256][3];
+	memset( palette, 0, sizeof(palette) );
+	unsigned char* compressed = new unsigned char[fileSize];
+	long compressedSize = 0;
+	long pos = 8;
+	bool ended = false;
+	while ( fileFormatOK && !ended ) {
+		if ( pos+12>fileSize ) {
+			fileFormatOK = false;
+			break;
+		}
+		unsigned long length = (unsigned long)getLongBE( fileData+pos );
+		const unsigned char* type = fileData+pos+4;
+		const unsigned char* chunk = fileData+pos+8;
+		if ( length>(unsigned long)(fileSize-pos-12) ) {
+			fileFormatOK = false;
+			break;
+		}
+		if ( memcmp( type, "IHDR", 4 )==0 && length>=13 ) {
+			NumCols = getLongBE( chunk );
+			NumRows = getLongBE( chunk+4 );
+			bitDepth = chunk[8];
+			colorType = chunk[9];
+			bool depthOK = ( colorType==0 && ( bitDepth==1 || bitDepth==2 || bitDepth==4 || bitDepth==8 || bitDepth==16 ) )
+						|| ( colorType==3 && ( bitDepth==1 || bitDepth==2 || bitDepth==4 || bitDepth==8 ) )
+						|| ( ( colorType==2 || colorType==4 || colorType==6 ) && ( bitDepth==8 || bitDepth==16 ) );
+			fileFormatOK = NumCols>0 && NumCols<=100000 && NumRows>0 && NumRows<=100000 
+							&& depthOK && chunk[10]==0 && chunk[11]==0 && chunk[12]==0;
+		}
+		else if ( memcmp( type, "PLTE", 4 )==0 ) {
+			for ( unsigned long i=0; i<length/3 && i<256; i++ ) {
+				memcpy( palette[i], chunk+3*i, 3 );
+			}
+		}
+		else if ( memcmp( type, "IDAT", 4 )==0 ) {
+			memcpy( compressed+compressedSize, chunk, length );
+			compressedSize += length;
+		}
+		else if ( memcmp( type, "IEND", 4 )==0 ) {
+			ended = true;
+		}
+		pos += 12+length;
+	}
+	delete[] fileData;
+
+	if ( !fileFormatOK || !ended || NumCols==0 ) {
+		Reset();
+		ErrorCode = FileFormatError;
+		fprintf(stderr, "Not a supported PNG file: %s.\n", filename);
+		delete[] compressed;
+		return false;
+	}
+
+	// Every row is a filter type byte followed by the packed samples
+	int channels = colorType==2 ? 3 : colorType==4 ? 2 : colorType==6 ? 4 : 1;
+	int bitsPerPixel = channels*bitDepth;
+	long rowBytes = (NumCols*bitsPerPixel+7)/8;
+	size_t rawSize = (size_t)(rowBytes+1)*NumRows;
+
+	// Deflate can't expand more than 1032 times, larger sizes are corrupt headers
+	if ( (double)rawSize>1032.0*compressedSize+64.0 ) {
+		Reset();
+		ErrorCode = FileFormatError;
+		fprintf(stderr, "Not a supported PNG file: %s.\n", filename);
+		delete[] compressed;
+		return false;
+	}
+	unsigned char* raw = new unsigned char[rawSize];
+	ImagePtr = new unsigned char[NumRows*GetNumBytesPerRow()]();
+	if ( !raw || !ImagePtr ) {
+		fprintf(stderr, "Unable to allocate memory for %ld x %ld bitmap: %s.\n", 
+				NumRows, NumCols, filename);
+		Reset();
+		ErrorCode = MemoryError;
+		delete[] compressed;
+		delete[] raw;
+		return false;
+	}
+
+	bool dataOK = InflateZlib( compressed, compressedSize, raw, rawSize );
+	delete[] compressed;
+
+	int pixelBytes = bitsPerPixel<8 ? 1 : bitsPerPixel/8;
+	const unsigned char* previous = 0;
+	for ( long i=0; dataOK && i<NumRows; i++ ) {
+		unsigned char* row = raw+i*(rowBytes+1);
+		dataOK = unfilterPngRow( row[0], row+1, previous, rowBytes, pixelBytes );
+		previous = row+1;
+
+		// PNG rows are stored top-down
+		unsigned char* cPtr = ImagePtr + (NumRows-1-i)*GetNumBytesPerRow();
+		const unsigned char* src = row+1;
+		int sampleBytes = bitDepth==16 ? 2 : 1;
+		for ( long j=0; j<NumCols; j++, cPtr+=3 ) {
+			if ( colorType==2 || colorType==6 ) {
+				const unsigned char* pixel = src + j*channels*sampleBytes;
+				cPtr[0] = pixel[0];
+				cPtr[1] = pixel[sampleBytes];
+				cPtr[2] = pixel[2*sampleBytes];
+			}
+			else if ( bitDepth>=8 ) {
+				int value = src[j*channels*sampleBytes];
+				if ( colorType==3 ) {
+					memcpy( cPtr, palette[value], 3 );
+				}
+				else {
+					cPtr[0] = cPtr[1] = cPtr[2] = (unsigned char)value;
+				}
+			}
+			else {
+				int pixelsPerByte = 8/bitDepth;
+				int shift = 8-bitDepth*(1+(int)(j%pixelsPerByte));
+				int value = (src[j/pixelsPerByte]>>shift)&((1<<bitDepth)-1);
+				if ( colorType==3 ) {
+					memcpy( cPtr, palette[value], 3 );
+				}
+				else {
+					cPtr[0] = cPtr[1] = cPtr[2] = (unsigned char)(value*255/((1<<bitDepth)-1));
+				}
+			}
+		}
+	}
+	delete[] raw;
+
+	if ( !dataOK ) {
+		fprintf( stderr, "Corrupt image data: %s.\n", filename );
+		Reset();
+		ErrorCode = ReadError;
+		return false;
+	}
+	return true;
+}
+
+/* ********************************************************************
+ *  unfilterPngRow
+ *  Undoes the filter of a row in place, pixelBytes is the distance to
+ *     the byte of the same sample in the pixel at the left.
+ **********************************************************************/
+
+bool RgbImage::unfilterPngRow( int filter, unsigned char* row, const unsigned char* previous, 
+							   long rowBytes, int pixelBytes )
+{
+	for ( long k=0; k<rowBytes; k++ ) {
+		int left = k>=pixelBytes ? row[k-pixelBytes] : 0;
+		int up = previous ? previous[k] : 0;
+		int upLeft = previous && k>=pixelBytes ? previous[k-pixelBytes] : 0;
+		int predictor;
+		switch ( filter ) {
+			case 0:	predictor = 0; break;				// None
+			case 1:	predictor = left; break;			// Sub
+			case 2:	predictor = up; break;				// Up
+			case 3:	predictor = (left+up)>>1; break;	// Average
+			case 4: {									// Paeth
+				int p = left+up-upLeft;
+				int pa = abs( p-left );
+				int pb = abs( p-up );
+				int pc = abs( p-upLeft );
+				predictor = ( pa<=pb && pa<=pc ) ? left : ( pb<=pc ? up : upLeft );
+				break;
+			}
+			default:
+				return false;
+		}
+		row[k] = (unsigned char)(row[k]+predictor);
+	}
+	return true;
+}
+
+/* ********************************************************************
+ *  readFile
+ *  Returns the whole contents of a file in a new[] buffer, or 0 with
+ *     the error code set.
+ **********************************************************************/
+
+unsigned char* RgbImage::readFile( const char* filename, long* size )
+{
+	FILE* infile = fopen( filename, "rb" );		// Open for reading binary data
+	if ( !infile ) {
+		fprintf(stderr, "Unable to open file: %s\n", filename);
+		ErrorCode = OpenError;
+		return 0;
+	}
+
+	*size = 0;
+	if ( fseek( infile, 0, SEEK_END )==0 ) {
+		*size = ftell( infile );
+		fseek( infile, 0, SEEK_SET );
+	}
+	unsigned char* data = *size>0 ? new unsigned char[*size] : 0;
+	if ( !data || (long)fread( data, 1, *size, infile )!=*size ) {
+		fprintf( stderr, "Unable to read file: %s.\n", filename );
+		ErrorCode = ReadError;
+		delete[] data;
+		data = 0;
+	}
+	fclose( infile );
+	return data;
+}
+
+short RgbImage::getShort( const unsigned char* bytes )
+{
+	// 16 bit integer in little endian form
+	return (short)( bytes[0] | (bytes[1]<<8) );
+}
+
+long RgbImage::getLongBE( const unsigned char* bytes )
 {  
-	// Read in 32 bit integer
-	unsigned char byte0, byte1, byte2, byte3;
-	byte0 = fgetc(infile);			// Read bytes, low order to high order
-	byte1 = fgetc(infile);
-	byte2 = fgetc(infile);
-	byte3 = fgetc(infile);
-
-	// Pack together
-	long ret = byte3;
-	ret <<= 8;
-	ret |= byte2;
-	ret <<= 8;
-	ret |= byte1;
-	ret <<= 8;
-	ret |= byte0;
-	return ret;
+	// 32 bit integer in big endian form, as in PNG files
+	return (long)( ((unsigned long)bytes[0]<<24) | ((unsigned long)bytes[1]<<16) 
+					| ((unsigned long)bytes[2]<<8) | (unsigned long)bytes[3] );
 }
 
-void RgbImage::skipChars( FILE* infile, int numChars )
+unsigned char RgbImage::maskChannel( unsigned long pixel, unsigned long mask )
 {
-	for ( int i=0; i<numChars; i++ ) {
-		fgetc( infile );
+	// Channel of a bit fields pixel scaled to 8 bits
+	if ( mask==0 ) {
+		return 0;
+	}
+	int shift = 0;
+	while ( !((mask>>shift)&1) ) {
+		shift++;
+	}
+	int bits = 0;
+	while ( bits+shift<32 && ((mask>>(shift+bits))&1) ) {
+		bits++;
+	}
+	unsigned long value = (pixel&mask)>>shift;
+	if ( bits>=8 ) {
+		return (unsigned char)(value>>(bits-8));
+	}
+	return (unsigned char)(value*255/((1UL<<bits)-1));
+}
+
+long RgbImage::getLong( const unsigned char* bytes )
+{  
+	// 32 bit signed integer in little endian form, sign extended where long is wider
+	return (long)(int)( (unsigned long)bytes[0] | ((unsigned long)bytes[1]<<8) 
+					| ((unsigned long)bytes[2]<<16) | ((unsigned long)bytes[3]<<24) );
+}
+
+void RgbImage::swapRedBlue( unsigned char* pixels, long numPixels )
+{
+	long i = 0;
+#ifdef RGBIMAGE_USE_SSSE3
+	// Five pixels per 16 byte load, the last byte belongs to the next pixel and is kept
+	const __m128i swap = _mm_setr_epi8( 2,1,0, 5,4,3, 8,7,6, 11,10,9, 14,13,12, 15 );
+	for ( ; i+6<=numPixels; i+=5 ) {
+		__m128i* block = (__m128i*)(pixels+3*i);
+		_mm_storeu_si128( block, _mm_shuffle_epi8( _mm_loadu_si128( block ), swap ) );
+	}
+#endif
+	for ( ; i<numPixels; i++ ) {
+		unsigned char* thePixel = pixels+3*i;
+		unsigned char blue = thePixel[0];
+		thePixel[0] = thePixel[2];
+		thePixel[2] = blue;
 	}
 }
 
@@ -176,83 +560,85 @@ void RgbImage::skipChars( FILE* infile, int numChars )
  *  Return true for success, false for failure.  Error code is available
  *     with a separate call.
  *  Author: Sam Buss, January 2003.
+ *  The whole file is built in memory and written with a single call.
  **********************************************************************/
 
 bool RgbImage::WriteBmpFile( const char* filename )
 {
-	FILE* outfile = fopen( filename, "wb" );		// Open for reading binary data
-	if ( !outfile ) {
-		fprintf(stderr, "Unable to open file: %s\n", filename);
-		ErrorCode = OpenError;
+	int rowLen = GetNumBytesPerRow();
+	size_t dataSize = (size_t)NumRows*rowLen;
+	unsigned char* fileData = new unsigned char[BmpHeaderSize+dataSize];
+	if ( !fileData ) {
+		fprintf(stderr, "Unable to allocate memory to write file: %s\n", filename);
+		ErrorCode = MemoryError;
 		return false;
 	}
 
-	fputc('B',outfile);
-	fputc('M',outfile);
-	int rowLen = GetNumBytesPerRow();
-	writeLong( 40+14+NumRows*rowLen, outfile );	// Length of file
-	writeShort( 0, outfile );					// Reserved for future use
-	writeShort( 0, outfile );
-	writeLong( 40+14, outfile );				// Offset to pixel data
-	writeLong( 40, outfile );					// header length
-	writeLong( NumCols, outfile );				// width in pixels
-	writeLong( NumRows, outfile );				// height in pixels (pos for bottom up)
-	writeShort( 1, outfile );		// number of planes
-	writeShort( 24, outfile );		// bits per pixel
-	writeLong( 0, outfile );		// no compression
-	writeLong( 0, outfile );		// not used if no compression
-	writeLong( 0, outfile );		// Pixels per meter
-	writeLong( 0, outfile );		// Pixels per meter
-	writeLong( 0, outfile );		// unused for 24 bits/pixel
-	writeLong( 0, outfile );		// unused for 24 bits/pixel
-
-	// Now write out the pixel data:
-	unsigned char* cPtr = ImagePtr;
+	unsigned char* header = fileData;
+	header[0] = 'B';
+	header[1] = 'M';
+	putLong( (long)(BmpHeaderSize+dataSize), header+2 );	// Length of file
+	putShort( 0, header+6 );					// Reserved for future use
+	putShort( 0, header+8 );
+	putLong( BmpHeaderSize, header+10 );		// Offset to pixel data
+	putLong( 40, header+14 );					// header length
+	putLong( NumCols, header+18 );				// width in pixels
+	putLong( NumRows, header+22 );				// height in pixels (pos for bottom up)
+	putShort( 1, header+26 );		// number of planes
+	putShort( 24, header+28 );		// bits per pixel
+	putLong( 0, header+30 );		// no compression
+	putLong( 0, header+34 );		// not used if no compression
+	putLong( 0, header+38 );		// Pixels per meter
+	putLong( 0, header+42 );		// Pixels per meter
+	putLong( 0, header+46 );		// unused for 24 bits/pixel
+	putLong( 0, header+50 );		// unused for 24 bits/pixel
+
+	// Pixel data in BGR order
+	unsigned char* cPtr = fileData+BmpHeaderSize;
+	if ( dataSize>0 ) {
+		memcpy( cPtr, ImagePtr, dataSize );
+	}
 	for ( int i=0; i<NumRows; i++ ) {
-		// Write out i-th row's data
-		int j;
-		for ( j=0; j<NumCols; j++ ) {
-			fputc( *(cPtr+2), outfile);		// Blue color value
-			fputc( *(cPtr+1), outfile);		// Blue color value
-			fputc( *(cPtr+0), outfile);		// Blue color value
-			cPtr+=3;
-		}
-		// Pad row to word boundary
-		int k=3*NumCols;					// Num bytes already read
-		for ( ; k<GetNumBytesPerRow(); k++ ) {
-			fputc( 0, outfile );				// Read and ignore padding;
-			cPtr++;
+		swapRedBlue( cPtr, NumCols );
+		for ( int k=3*NumCols; k<rowLen; k++ ) {
+			cPtr[k] = 0;					// Pad row to word boundary
 		}
+		cPtr += rowLen;
 	}
 
+	FILE* outfile = fopen( filename, "wb" );		// Open for reading binary data
+	if ( !outfile ) {
+		fprintf(stderr, "Unable to open file: %s\n", filename);
+		ErrorCode = OpenError;
+		delete[] fileData;
+		return false;
+	}
+
+	bool written = fwrite( fileData, 1, BmpHeaderSize+dataSize, outfile )==BmpHeaderSize+dataSize;
 	fclose( outfile );	// Close the file
+	delete[] fileData;
+	if ( !written ) {
+		fprintf(stderr, "Unable to write file: %s\n", filename);
+		ErrorCode = WriteError;
+		return false;
+	}
 	return true;
 }
 
-void RgbImage::writeLong( long data, FILE* outfile )
+void RgbImage::putLong( long data, unsigned char* bytes )
 {  
-	// Read in 32 bit integer
-	unsigned char byte0, byte1, byte2, byte3;
-	byte0 = (unsigned char)(data&0x000000ff);		// Write bytes, low order to high order
-	byte1 = (unsigned char)((data>>8)&0x000000ff);
-	byte2 = (unsigned char)((data>>16)&0x000000ff);
-	byte3 = (unsigned char)((data>>24)&0x000000ff);
-
-	fputc( byte0, outfile );
-	fputc( byte1, outfile );
-	fputc( byte2, outfile );
-	fputc( byte3, outfile );
+	// 32 bit integer, low order to high order
+	bytes[0] = (unsigned char)(data&0x000000ff);
+	bytes[1] = (unsigned char)((data>>8)&0x000000ff);
+	bytes[2] = (unsigned char)((data>>16)&0x000000ff);
+	bytes[3] = (unsigned char)((data>>24)&0x000000ff);
 }
 
-void RgbImage::writeShort( short data, FILE* outfile )
+void RgbImage::putShort( short data, unsigned char* bytes )
 {  
-	// Read in 32 bit integer
-	unsigned char byte0, byte1;
-	byte0 = data&0x000000ff;		// Write bytes, low order to high order
-	byte1 = (data>>8)&0x000000ff;
-
-	fputc( byte0, outfile );
-	fputc( byte1, outfile );
+	// 16 bit integer, low order to high order
+	bytes[0] = (unsigned char)(data&0x000000ff);
+	bytes[1] = (unsigned char)((data>>8)&0x000000ff);
 }
 
 
@@ -337,17 +723,17 @@ bool RgbImage::LoadFromOpenglBuffer()					// Load the bitmap from the current Op
 	assert ( vWidth>=NumCols && vHeight>=NumRows );
 	int oldGlRowLen;
 	if ( vWidth>=NumCols ) {
-		glGetIntegerv( GL_UNPACK_ROW_LENGTH, &oldGlRowLen );
-		glPixelStorei( GL_UNPACK_ROW_LENGTH, NumCols );
+		glGetIntegerv( GL_PACK_ROW_LENGTH, &oldGlRowLen );
+		glPixelStorei( GL_PACK_ROW_LENGTH, NumCols );
 	}
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);	// Same padding as the rows of the image
 
 	// Get the frame buffer data.
 	glReadPixels( 0, 0, NumCols, NumRows, GL_RGB, GL_UNSIGNED_BYTE, ImagePtr);
 
 	// Restore the row length in glPixelStorei  (really ought to restore alignment too).
 	if ( vWidth>=NumCols ) {
-		glPixelStorei( GL_UNPACK_ROW_LENGTH, oldGlRowLen );
+		glPixelStorei( GL_PACK_ROW_LENGTH, oldGlRowLen );
 	}	
 	return true;
 }
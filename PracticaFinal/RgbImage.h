@@ -27,6 +27,11 @@
 // Include the next line to turn off the routines that use OpenGL
 // #define RGBIMAGE_DONT_USE_OPENGL
 
+// Byte shuffles for the BGR <-> RGB conversion when the target has SSSE3 (AVX on MSVC)
+#if !defined(RGBIMAGE_USE_SSSE3) && (defined(__SSSE3__) || defined(__AVX__))
+#define RGBIMAGE_USE_SSSE3
+#endif
+
 class RgbImage
 {
 public:
@@ -35,7 +40,9 @@ public:
 	RgbImage( int numRows, int numCols );	// Initialize a blank bitmap of this size.
 	~RgbImage();
 
+	bool LoadImageFile( const char* filename );		// Loads a BMP or PNG file, chosen by its signature
 	bool LoadBmpFile( const char *filename );		// Loads the bitmap from the specified file
+	bool LoadPngFile( const char* filename );		// Loads the PNG image from the specified file
 	bool WriteBmpFile( const char* filename );		// Write the bitmap to the specified file
 #ifndef RGBIMAGE_DONT_USE_OPENGL
 	bool LoadFromOpenglBuffer();					// Load the bitmap from the current OpenGL buffer
@@ -61,7 +68,7 @@ public:
 	enum {
 		NoError = 0,
 		OpenError = 1,			// Unable to open file for reading
-		FileFormatError = 2,	// Not recognized as a 24 bit BMP file
+		FileFormatError = 2,	// Not recognized as a supported BMP or PNG file
 		MemoryError = 3,		// Unable to allocate memory for image data
 		ReadError = 4,			// End of file reached prematurely
 		WriteError = 5			// Unable to write out data (or no date to write out)
@@ -76,11 +83,20 @@ private:
 	long NumCols;				// number of columns in image
 	int ErrorCode;				// error code
 
-	static short readShort( FILE* infile );
-	static long readLong( FILE* infile );
-	static void skipChars( FILE* infile, int numChars );
-	static void writeLong( long data, FILE* outfile );
-	static void writeShort( short data, FILE* outfile );
+	enum { BmpHeaderSize = 14+40 };	// File header plus info header
+	enum { BmpRgb = 0, BmpRle8 = 1, BmpRle4 = 2, BmpBitFields = 3 };	// Compression types
+
+	unsigned char* readFile( const char* filename, long* size );
+	bool decodeBmpRle( const unsigned char* data, long size, int bitsPerPixel, const unsigned char palette[256][3] );
+	static bool unfilterPngRow( int filter, unsigned char* row, const unsigned char* previous, long rowBytes, int pixelBytes );
+
+	static short getShort( const unsigned char* bytes );
+	static long getLong( const unsigned char* bytes );
+	static long getLongBE( const unsigned char* bytes );
+	static unsigned char maskChannel( unsigned long pixel, unsigned long mask );
+	static void swapRedBlue( unsigned char* pixels, long numPixels );	// BGR <-> RGB in place
+	static void putLong( long data, unsigned char* bytes );
+	static void putShort( short data, unsigned char* bytes );
 	
 	static unsigned char doubleToUnsignedChar( double x );
 
@@ -100,7 +116,7 @@ inline RgbImage::RgbImage( const char* filename )
 	NumCols = 0;
 	ImagePtr = 0;
 	ErrorCode = 0;
-	LoadBmpFile( filename );
+	LoadImageFile( filename );
 }
 
 inline RgbImage::~RgbImage()
@@ -0,0 +1,316 @@
+#include "ShaderRenderer.h"
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace
+{
+    const char* FRAME_BLOCK =
+        "#version 330 core\n"
+        "layout(std140) uniform Frame\n"
+        "{\n"
+        "    mat4 view;\n"
+        "    mat4 projection;\n"
+        "    vec4 lightPosition[2];\n"
+        "    vec4 lightAmbient;\n"
+        "    vec4 lightDiffuse;\n"
+        "    vec4 attenuation;\n"
+        "    vec4 globalAmbient;\n"
+        "};\n";
+
+    // The legacy cube has no normals, so every face uses the default normal (0, 0, 1)
+    const char* SHADER_VERTEX_SOURCE =
+        "layout(location = 0) in vec3 position;\n"
+        "layout(location = 1) in vec2 uv;\n"
+        "layout(location = 2) in vec3 instanceOffset;\n"
+        "layout(location = 3) in vec3 instanceColor;\n"
+        "out vec3 eyePosition;\n"
+        "out vec3 eyeNormal;\n"
+        "out vec3 color;\n"
+        "out vec2 texCoord;\n"
+        "void main()\n"
+        "{\n"
+        "    vec4 eye = view * vec4(position + instanceOffset, 1.0);\n"
+        "    eyePosition = eye.xyz;\n"
+        "    eyeNormal = mat3(view) * vec3(0.0, 0.0, 1.0);\n"
+        "    color = instanceColor;\n"
+        "    texCoord = uv;\n"
+        "    gl_Position = projection * eye;\n"
+        "}\n";
+
+    // Same light equation as the fixed-function path, evaluated per fragment.
+    // The texture darkens the lit color like the GL_BLEND environment, or replaces it for the pause screen.
+    const char* SHADER_FRAGMENT_SOURCE =
+        "uniform sampler2D sceneTexture;\n"
+        "uniform int replaceTexture;\n"
+        "uniform float alpha;\n"
+        "in vec3 eyePosition;\n"
+        "in vec3 eyeNormal;\n"
+        "in vec3 color;\n"
+        "in vec2 texCoord;\n"
+        "out vec4 fragColor;\n"
+        "void main()\n"
+        "{\n"
+        "    vec4 texel = texture(sceneTexture, texCoord);\n"
+        "    if (replaceTexture != 0)\n"
+        "    {\n"
+        "        fragColor = texel;\n"
+        "        return;\n"
+        "    }\n"
+        "    vec3 normal = normalize(eyeNormal);\n"
+        "    vec3 lit = globalAmbient.rgb * color;\n"
+        "    for (int i = 0; i < 2; i++)\n"
+        "    {\n"
+        "        vec3 toLight = lightPosition[i].xyz - eyePosition;\n"
+        "        float distance = length(toLight);\n"
+        "        float attenuationFactor = 1.0 / (attenuation.x + attenuation.y * distance + attenuation.z * distance * distance);\n"
+        "        float diffuse = max(dot(normal, toLight / distance), 0.0);\n"
+        "        lit += attenuationFactor * color * (lightAmbient.rgb + diffuse * lightDiffuse.rgb);\n"
+        "    }\n"
+        "    fragColor = vec4(min(lit, 1.0) * (1.0 - texel.rgb), texel.a * alpha);\n"
+        "}\n";
+
+    // Pause screen quad, already placed where the legacy path translates and scales it
+    const CubeVertex PAUSE_QUAD[SHADER_PAUSE_VERTICES] =
+    {
+        { -6.0f,  2.0f, 14.0f, 0.0f, 0.0f }, { 14.0f,  2.0f, 14.0f, 1.0f, 0.0f }, { 14.0f, 10.0f, 14.0f, 1.0f, 1.0f },
+        { -6.0f,  2.0f, 14.0f, 0.0f, 0.0f }, { 14.0f, 10.0f, 14.0f, 1.0f, 1.0f }, { -6.0f, 10.0f, 14.0f, 0.0f, 1.0f }
+    };
+
+    // Same lights as initLights
+    const FrameUniforms DEFAULT_FRAME =
+    {
+        { 0.0f }, { 0.0f },
+        { { 4.0f, 4.0f, 5.0f, 1.0f }, { -4.0f, 4.0f, 5.0f, 1.0f } },
+        { 0.5f, 0.5f, 0.5f, 1.0f },
+        { 1.0f, 1.0f, 1.0f, 1.0f },
+        { 0.5f, 0.01f, 0.01f, 0.0f },
+        { 0.2f, 0.2f, 0.2f, 0.2f }
+    };
+
+    void SetVertexLayout()
+    {
+        glEnableVertexAttribArray(SHADER_ATTRIB_POSITION);
+        glVertexAttribPointer(SHADER_ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(CubeVertex), (const GLvoid*)offsetof(CubeVertex, x));
+        glEnableVertexAttribArray(SHADER_ATTRIB_TEXCOORD);
+        glVertexAttribPointer(SHADER_ATTRIB_TEXCOORD, 2, GL_FLOAT, GL_FALSE, sizeof(CubeVertex), (const GLvoid*)offsetof(CubeVertex, u));
+    }
+}
+
+ShaderRenderer::ShaderRenderer()
+{
+    m_program           = 0;
+    m_cubeArray         = 0;
+    m_cubeBuffer        = 0;
+    m_pauseArray        = 0;
+    m_pauseBuffer       = 0;
+    m_uniformBuffer     = 0;
+    m_cubeTexture       = 0;
+    m_pauseTexture      = 0;
+    m_replaceLocation   = -1;
+    m_alphaLocation     = -1;
+    m_frame             = DEFAULT_FRAME;
+}
+
+bool ShaderRenderer::Init(GLuint cubeTexture, GLuint pauseTexture)
+{
+    if (!GLEW_VERSION_3_3)
+    {
+        ERROR_LOG("Shader renderer needs OpenGL 3.3.\n");
+        return false;
+    }
+
+    GLuint vertexShader = CubeRenderer::CompileShader(GL_VERTEX_SHADER, (std::string(FRAME_BLOCK) + SHADER_VERTEX_SOURCE).c_str());
+    GLuint fragmentShader = CubeRenderer::CompileShader(GL_FRAGMENT_SHADER, (std::string(FRAME_BLOCK) + SHADER_FRAGMENT_SOURCE).c_str());
+    if (!vertexShader || !fragmentShader)
+    {
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        return false;
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked)
+    {
+        char log[BUFFER_SIZE];
+        glGetProgramInfoLog(program, BUFFER_SIZE, nullptr, log);
+        ERROR_LOG("Failed to link scene program: %s\n", log);
+        glDeleteProgram(program);
+        return false;
+    }
+
+    glUniformBlockBinding(program, glGetUniformBlockIndex(program, "Frame"), SHADER_FRAME_BINDING);
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "sceneTexture"), 0);
+    m_replaceLocation = glGetUniformLocation(program, "replaceTexture");
+    m_alphaLocation = glGetUniformLocation(program, "alpha");
+    glUseProgram(0);
+
+    CubeVertex vertices[CUBE_MESH_VERTICES];
+    CubeRenderer::BuildMesh(vertices);
+
+    // The instance attributes are pointed at the buffer of each batch when it is drawn
+    glGenVertexArrays(1, &m_cubeArray);
+    glBindVertexArray(m_cubeArray);
+    glGenBuffers(1, &m_cubeBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_cubeBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    SetVertexLayout();
+    glEnableVertexAttribArray(SHADER_ATTRIB_OFFSET);
+    glVertexAttribDivisor(SHADER_ATTRIB_OFFSET, 1);
+    glEnableVertexAttribArray(SHADER_ATTRIB_COLOR);
+    glVertexAttribDivisor(SHADER_ATTRIB_COLOR, 1);
+
+    glGenVertexArrays(1, &m_pauseArray);
+    glBindVertexArray(m_pauseArray);
+    glGenBuffers(1, &m_pauseBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_pauseBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(PAUSE_QUAD), PAUSE_QUAD, GL_STATIC_DRAW);
+    SetVertexLayout();
+    glBindVertexArray(0);
+
+    glGenBuffers(1, &m_uniformBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_uniformBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, SHADER_FRAME_BINDING, m_uniformBuffer);
+
+    m_cubeTexture = cubeTexture;
+    m_pauseTexture = pauseTexture;
+    m_program = program;
+
+    INFO_LOG("Shader renderer enabled.\n");
+    return true;
+}
+
+void ShaderRenderer::Release()
+{
+    if (m_program)
+        glDeleteProgram(m_program);
+
+    GLuint arrays[] = { m_cubeArray, m_pauseArray };
+    glDeleteVertexArrays(2, arrays);
+
+    GLuint buffers[] = { m_cubeBuffer, m_pauseBuffer, m_uniformBuffer };
+    glDeleteBuffers(3, buffers);
+
+    m_program = 0;
+    m_cubeArray = m_pauseArray = 0;
+    m_cubeBuffer = m_pauseBuffer = m_uniformBuffer = 0;
+}
+
+void ShaderRenderer::SetViewport(int32 width, int32 height)
+{
+    glViewport(0, 0, width, height);
+    Perspective(m_frame.projection, 60.0f, GLfloat(width) / GLfloat(std::max(height, 1)), 0.1f, 50.0f);
+}
+
+void ShaderRenderer::BeginFrame(const GLfloat eye[3], const GLfloat center[3], const GLfloat up[3])
+{
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    LookAt(m_frame.view, eye, center, up);
+    for (uint8 i = 0; i < 12; i++)
+        m_frame.view[i] *= 0.5f;
+
+    glBindBuffer(GL_UNIFORM_BUFFER, m_uniformBuffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &m_frame);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void ShaderRenderer::Draw(CubeBatch& batch, GLfloat alpha /*=1.0f*/)
+{
+    if (!m_program || batch.m_instances.empty())
+        return;
+
+    glBindVertexArray(m_cubeArray);
+    batch.Upload();
+    glVertexAttribPointer(SHADER_ATTRIB_OFFSET, 3, GL_FLOAT, GL_FALSE, sizeof(CubeInstance), (const GLvoid*)offsetof(CubeInstance, x));
+    glVertexAttribPointer(SHADER_ATTRIB_COLOR, 3, GL_FLOAT, GL_FALSE, sizeof(CubeInstance), (const GLvoid*)offsetof(CubeInstance, r));
+
+    bool translucent = alpha < 1.0f;
+    if (translucent)
+    {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glDepthMask(GL_FALSE);
+    }
+
+    glUseProgram(m_program);
+    glUniform1i(m_replaceLocation, 0);
+    glUniform1f(m_alphaLocation, alpha);
+    glBindTexture(GL_TEXTURE_2D, m_cubeTexture);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, CUBE_MESH_VERTICES, GLsizei(batch.m_instances.size()));
+
+    if (translucent)
+    {
+        glDepthMask(GL_TRUE);
+        glDisable(GL_BLEND);
+    }
+
+    glBindVertexArray(0);
+}
+
+void ShaderRenderer::DrawPause()
+{
+    if (!m_program)
+        return;
+
+    glBindVertexArray(m_pauseArray);
+    glUseProgram(m_program);
+    glUniform1i(m_replaceLocation, 1);
+    glBindTexture(GL_TEXTURE_2D, m_pauseTexture);
+    glDrawArrays(GL_TRIANGLES, 0, SHADER_PAUSE_VERTICES);
+
+    glBindVertexArray(0);
+}
+
+void ShaderRenderer::Perspective(GLfloat matrix[16], GLfloat fovy, GLfloat aspect, GLfloat zNear, GLfloat zFar)
+{
+    // Same matrix as gluPerspective, column-major
+    GLfloat f = 1.0f / tanf(fovy * 3.14159265f / 360.0f);
+    memset(matrix, 0, sizeof(GLfloat) * 16);
+    matrix[0] = f / aspect;
+    matrix[5] = f;
+    matrix[10] = (zFar + zNear) / (zNear - zFar);
+    matrix[11] = -1.0f;
+    matrix[14] = 2.0f * zFar * zNear / (zNear - zFar);
+}
+
+void ShaderRenderer::LookAt(GLfloat matrix[16], const GLfloat eye[3], const GLfloat center[3], const GLfloat up[3])
+{
+    // Same matrix as gluLookAt, column-major
+    GLfloat f[3] = { center[0] - eye[0], center[1] - eye[1], center[2] - eye[2] };
+    GLfloat length = sqrtf(f[0] * f[0] + f[1] * f[1] + f[2] * f[2]);
+    for (uint8 i = 0; i < 3; i++)
+        f[i] /= length;
+
+    GLfloat s[3] = { f[1] * up[2] - f[2] * up[1], f[2] * up[0] - f[0] * up[2], f[0] * up[1] - f[1] * up[0] };
+    length = sqrtf(s[0] * s[0] + s[1] * s[1] + s[2] * s[2]);
+    for (uint8 i = 0; i < 3; i++)
+        s[i] /= length;
+
+    GLfloat u[3] = { s[1] * f[2] - s[2] * f[1], s[2] * f[0] - s[0] * f[2], s[0] * f[1] - s[1] * f[0] };
+
+    for (uint8 i = 0; i < 3; i++)
+    {
+        matrix[i * 4 + 0] = s[i];
+        matrix[i * 4 + 1] = u[i];
+        matrix[i * 4 + 2] = -f[i];
+        matrix[i * 4 + 3] = 0.0f;
+    }
+
+    matrix[12] = -(s[0] * eye[0] + s[1] * eye[1] + s[2] * eye[2]);
+    matrix[13] = -(u[0] * eye[0] + u[1] * eye[1] + u[2] * eye[2]);
+    matrix[14] = f[0] * eye[0] + f[1] * eye[1] + f[2] * eye[2];
+    matrix[15] = 1.0f;
+}
@@ -0,0 +1,67 @@
+#ifndef SHADER_RENDERER_H
+#define SHADER_RENDERER_H
+
+#include <GL/glew.h>
+#include "Common.h"
+#include "CubeRenderer.h"
+
+#define SHADER_ATTRIB_POSITION      0
+#define SHADER_ATTRIB_TEXCOORD      1
+#define SHADER_ATTRIB_OFFSET        2
+#define SHADER_ATTRIB_COLOR         3
+#define SHADER_FRAME_BINDING        0 // Uniform buffer binding point of the Frame block
+#define SHADER_PAUSE_VERTICES       6
+
+// Per-frame uniforms, laid out as the std140 Frame block of the shaders
+struct FrameUniforms
+{
+    GLfloat view[16];
+    GLfloat projection[16];
+    GLfloat lightPosition[2][4];    // Eye space
+    GLfloat lightAmbient[4];
+    GLfloat lightDiffuse[4];
+    GLfloat attenuation[4];         // Constant, linear and quadratic
+    GLfloat globalAmbient[4];
+};
+
+// Renderer for core profile contexts: no fixed-function state or matrix stacks, the camera goes
+// in a uniform buffer and the two point lights of the scene are computed per fragment.
+// Draws the same CubeBatch objects as CubeRenderer.
+class ShaderRenderer
+{
+public:
+    ShaderRenderer();
+
+    // Needs a 3.3 context, returns false if the program can't be built
+    bool Init(GLuint cubeTexture, GLuint pauseTexture);
+    bool IsAvailable() const { return m_program != 0; }
+
+    void SetViewport(int32 width, int32 height);
+
+    // Clears the frame and uploads the camera, the scene is scaled by half like the legacy path
+    void BeginFrame(const GLfloat eye[3], const GLfloat center[3], const GLfloat up[3]);
+    // Batches with alpha below 1 are blended over the frame without writing depth, draw them last
+    void Draw(CubeBatch& batch, GLfloat alpha = 1.0f);
+    void DrawPause();
+
+    void Release();
+
+private:
+    static void Perspective(GLfloat matrix[16], GLfloat fovy, GLfloat aspect, GLfloat zNear, GLfloat zFar);
+    static void LookAt(GLfloat matrix[16], const GLfloat eye[3], const GLfloat center[3], const GLfloat up[3]);
+
+    GLuint m_program;
+    GLuint m_cubeArray;
+    GLuint m_cubeBuffer;
+    GLuint m_pauseArray;
+    GLuint m_pauseBuffer;
+    GLuint m_uniformBuffer;
+    GLuint m_cubeTexture;
+    GLuint m_pauseTexture;
+    GLint m_replaceLocation;
+    GLint m_alphaLocation;
+
+    FrameUniforms m_frame;
+};
+
+#endif
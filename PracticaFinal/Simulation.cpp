@@ -0,0 +1,35 @@
+#include "Simulation.h"
+#include "AllocationCounter.h"
+#include "Game.h"
+#include "Bot.h"
+
+SimulationResult RunSimulation(uint64 seed, uint8 policy, uint64 maxSteps /*=DEFAULT_SIMULATION_MAX_STEPS*/, TraceSink* trace /*=nullptr*/,
+    SimulationFinishedFunction onFinished /*=nullptr*/, void* context /*=nullptr*/)
+{
+    Game* game = Game::CreateNewGame(DEFAULT_LEVEL, seed, policy);
+    game->SetTraceSink(trace);
+    game->StartGame();
+
+    // Pools are warm once the game started, a step should never reach the heap
+    uint64 allocations = GetThreadAllocations();
+    uint64 steps = 0;
+    while (steps < maxSteps && game->Step(Bot::ChooseInputs(*game)))
+        steps++;
+
+    allocations = GetThreadAllocations() - allocations;
+
+    SimulationResult result;
+    result.seed = seed;
+    result.lines = game->GetLinesCompleted();
+    result.points = game->GetPoints();
+    result.level = game->GetLevel();
+    result.steps = steps;
+    result.gameTime = game->GetGameTime();
+    result.allocations = allocations;
+
+    if (onFinished)
+        onFinished(*game, result, context);
+
+    delete game;
+    return result;
+}
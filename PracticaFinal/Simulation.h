@@ -0,0 +1,31 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "Common.h"
+
+class Game;
+class TraceSink;
+
+#define DEFAULT_SIMULATION_MAX_STEPS    1000000
+
+struct SimulationResult
+{
+    uint64 seed;
+    uint32 lines;
+    uint32 points;
+    uint32 level;
+    uint64 steps;
+    uint64 gameTime;
+    uint64 allocations;     // Heap allocations made by the steps, only counted in debug builds
+};
+
+// Called with the final state of the game before it is destroyed
+typedef void (*SimulationFinishedFunction)(const Game& game, const SimulationResult& result, void* context);
+
+// Plays a whole headless game driven by the bot. Everything it touches is owned by
+// the game it creates, so several simulations can run at the same time in different threads.
+// The optional trace sink must only be shared by simulations running in the same thread.
+SimulationResult RunSimulation(uint64 seed, uint8 policy, uint64 maxSteps = DEFAULT_SIMULATION_MAX_STEPS, TraceSink* trace = nullptr,
+    SimulationFinishedFunction onFinished = nullptr, void* context = nullptr);
+
+#endif
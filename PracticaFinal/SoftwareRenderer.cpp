@@ -0,0 +1,87 @@
+#include "SoftwareRenderer.h"
+#include "Block.h"
+#include "Board.h"
+#include "Game.h"
+#include "Panel.h"
+#include "RgbImage.h"
+#include <cstring>
+
+SoftwareRenderer::SoftwareRenderer(uint32 cellPixels /*=SOFTWARE_CELL_PIXELS*/)
+{
+    m_cellPixels = std::max<uint32>(cellPixels, 2 * SOFTWARE_BEVEL_PIXELS + 1);
+}
+
+void SoftwareRenderer::Render(const Game& game, RgbImage& image) const
+{
+    if (image.GetNumRows() != long(GetHeight()) || image.GetNumCols() != long(GetWidth()))
+    {
+        ERROR_LOG("Software render target is %ldx%ld, expected %ux%u.\n", image.GetNumCols(), image.GetNumRows(), GetWidth(), GetHeight());
+        return;
+    }
+
+    for (long row = 0; row < image.GetNumRows(); row++)
+        memset(image.GetRgbPixel(row, 0), 0, image.GetNumBytesPerRow());
+
+    ForEachPanelCell([&](float x, float y) { DrawCell(image, x, y, COLOR_GRAY); });
+
+    game.GetBoard().ForEachCell([&](int32 x, int32 y, uint8 color) { DrawCell(image, float(x), float(y), color); });
+
+    DrawBlock(image, game.GetActiveBlock());
+    DrawBlock(image, game.GetNextBlock());
+}
+
+bool SoftwareRenderer::WriteBmpFile(const Game& game, const char* filename) const
+{
+    RgbImage image(GetHeight(), GetWidth());
+    if (!image.ImageLoaded())
+        return false;
+
+    Render(game, image);
+    return image.WriteBmpFile(filename);
+}
+
+void SoftwareRenderer::DrawBlock(RgbImage& image, const Block* block) const
+{
+    if (!block)
+        return;
+
+    const BlockRotation& rotation = Block::GetRotationOfType(block->GetType(), block->GetRotation());
+    for (uint8 i = 0; i < NUM_BLOCK_SUBBLOCKS; i++)
+        DrawCell(image, float(block->GetPositionX() + rotation.cells[i].x), float(block->GetPositionY() + rotation.cells[i].y), block->GetColor());
+}
+
+void SoftwareRenderer::DrawCell(RgbImage& image, float x, float y, uint8 color) const
+{
+    int32 column = int32(floorf(x + 0.5f)) - SOFTWARE_VIEW_LEFT;
+    int32 row = int32(floorf(y + 0.5f)) - SOFTWARE_VIEW_BOTTOM;
+    if (column < 0 || column >= SOFTWARE_VIEW_COLUMNS || row < 0 || row >= SOFTWARE_VIEW_ROWS)
+        return;
+
+    // Flat material color with a bevel, lighter on the top and left edges and darker on the others.
+    // BMP rows go bottom-up like the board, so image row 0 is the floor.
+    const float* rgb = Block::GetColorValue(color);
+    unsigned char shades[3][3];
+    const float factors[3] = { 1.0f, 1.25f, 0.6f };
+    for (uint8 shade = 0; shade < 3; shade++)
+        for (uint8 c = 0; c < 3; c++)
+            shades[shade][c] = (unsigned char)(std::min(rgb[c] * factors[shade], 1.0f) * 255.0f + 0.5f);
+
+    uint32 bevel = SOFTWARE_BEVEL_PIXELS;
+    uint32 last = m_cellPixels - 1;
+    for (uint32 py = 0; py < m_cellPixels; py++)
+    {
+        unsigned char* pixel = image.GetRgbPixel(long(row * m_cellPixels + py), long(column * m_cellPixels));
+        for (uint32 px = 0; px < m_cellPixels; px++, pixel += 3)
+        {
+            uint8 shade = 0;
+            if (py >= last - bevel + 1 || px < bevel)
+                shade = 1;
+            if (py < bevel || px >= last - bevel + 1)
+                shade = 2;
+
+            pixel[0] = shades[shade][0];
+            pixel[1] = shades[shade][1];
+            pixel[2] = shades[shade][2];
+        }
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef SOFTWARE_RENDERER_H
+#define SOFTWARE_RENDERER_H
+
+#include "Common.h"
+
+class Block;
+class Game;
+class RgbImage;
+
+#define SOFTWARE_CELL_PIXELS        16
+#define SOFTWARE_BEVEL_PIXELS       2
+#define SOFTWARE_VIEW_LEFT          -1 // Left wall of the board
+#define SOFTWARE_VIEW_BOTTOM        -1 // Floor of the board
+#define SOFTWARE_VIEW_COLUMNS       23 // Up to the right side of the next block box
+#define SOFTWARE_VIEW_ROWS          19 // Up to the rows where blocks spawn
+
+// Renders a game state without any graphics context: the front view of the panel, the locked
+// cells and the active and next blocks is rasterized on the CPU into an RgbImage.
+// Output only depends on the game state, so images of the same state are identical on every machine.
+class SoftwareRenderer
+{
+public:
+    SoftwareRenderer(uint32 cellPixels = SOFTWARE_CELL_PIXELS);
+
+    uint32 GetWidth() const { return SOFTWARE_VIEW_COLUMNS * m_cellPixels; }
+    uint32 GetHeight() const { return SOFTWARE_VIEW_ROWS * m_cellPixels; }
+
+    // The image must have GetHeight() rows and GetWidth() columns
+    void Render(const Game& game, RgbImage& image) const;
+
+    // Renders into a new image and writes it as a BMP file, returns false if it can't be written
+    bool WriteBmpFile(const Game& game, const char* filename) const;
+
+private:
+    void DrawBlock(RgbImage& image, const Block* block) const;
+    void DrawCell(RgbImage& image, float x, float y, uint8 color) const;
+
+    uint32 m_cellPixels;
+};
+
+#endif
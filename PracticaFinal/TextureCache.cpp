@@ -0,0 +1,159 @@
+#include "TextureCache.h"
+#include "RgbImage.h"
+#include <cstring>
+#include <sys/stat.h>
+
+TextureCache::TextureCache()
+{
+    m_header = nullptr;
+}
+
+bool TextureCache::GetSourceStamp(const char* sourcePath, int64& time, int64& size)
+{
+    struct stat info;
+    if (stat(sourcePath, &info) != 0)
+        return false;
+
+    time = int64(info.st_mtime);
+    size = int64(info.st_size);
+    return true;
+}
+
+uint32 TextureCache::GetLevelCount(int32 width, int32 height)
+{
+    uint32 levels = 1;
+    while (width > 1 || height > 1)
+    {
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+        levels++;
+    }
+
+    return levels;
+}
+
+bool TextureCache::Open(const char* sourcePath)
+{
+    Close();
+
+    int64 sourceTime, sourceSize;
+    if (!GetSourceStamp(sourcePath, sourceTime, sourceSize))
+        return false;
+
+    std::string cachePath = std::string(sourcePath) + TEXTURE_CACHE_EXTENSION;
+    if (!m_file.Open(cachePath.c_str()))
+        return false;
+
+    // Only the header is checked, the pixels are used in place
+    const TextureCacheHeader* header = (const TextureCacheHeader*)m_file.GetData();
+    bool valid = m_file.GetSize() >= sizeof(TextureCacheHeader) && header->magic == TEXTURE_CACHE_MAGIC && header->version == TEXTURE_CACHE_VERSION
+        && header->sourceTime == sourceTime && header->sourceSize == sourceSize && header->channels == 3
+        && header->width > 0 && header->height > 0 && header->levels == GetLevelCount(header->width, header->height);
+
+    if (valid)
+    {
+        size_t dataSize = 0;
+        for (uint32 level = 0; level < header->levels; level++)
+            dataSize += GetLevelSize(std::max(1, header->width >> level), std::max(1, header->height >> level));
+
+        valid = m_file.GetSize() == sizeof(TextureCacheHeader) + dataSize;
+    }
+
+    if (!valid)
+    {
+        DEBUG_LOG("Texture cache of %s is stale or corrupt.\n", sourcePath);
+        m_file.Close();
+        return false;
+    }
+
+    m_header = header;
+    return true;
+}
+
+void TextureCache::Close()
+{
+    m_file.Close();
+    m_header = nullptr;
+}
+
+const unsigned char* TextureCache::GetLevel(uint32 level, int32& width, int32& height) const
+{
+    if (!m_header || level >= m_header->levels)
+        return nullptr;
+
+    const unsigned char* data = m_file.GetData() + sizeof(TextureCacheHeader);
+    for (uint32 i = 0; i < level; i++)
+        data += GetLevelSize(std::max(1, m_header->width >> i), std::max(1, m_header->height >> i));
+
+    width = std::max(1, m_header->width >> level);
+    height = std::max(1, m_header->height >> level);
+    return data;
+}
+
+bool TextureCache::Write(const char* sourcePath, const RgbImage& image)
+{
+    TextureCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = TEXTURE_CACHE_MAGIC;
+    header.version = TEXTURE_CACHE_VERSION;
+    header.width = int32(image.GetNumCols());
+    header.height = int32(image.GetNumRows());
+    header.channels = 3;
+    if (!image.ImageLoaded() || !GetSourceStamp(sourcePath, header.sourceTime, header.sourceSize))
+        return false;
+
+    header.levels = GetLevelCount(header.width, header.height);
+
+    size_t fileSize = sizeof(header);
+    for (uint32 level = 0; level < header.levels; level++)
+        fileSize += GetLevelSize(std::max(1, header.width >> level), std::max(1, header.height >> level));
+
+    std::vector<unsigned char> file(fileSize, 0);
+    memcpy(file.data(), &header, sizeof(header));
+
+    unsigned char* level = file.data() + sizeof(header);
+    memcpy(level, image.ImageData(), GetLevelSize(header.width, header.height));
+
+    // Each level averages 2x2 blocks of the previous one, like glGenerateMipmap odd sizes round down
+    int32 width = header.width;
+    int32 height = header.height;
+    for (uint32 i = 1; i < header.levels; i++)
+    {
+        const unsigned char* source = level;
+        size_t sourceRow = (3 * width + 3) & ~3;
+        level += GetLevelSize(width, height);
+
+        int32 nextWidth = std::max(1, width / 2);
+        int32 nextHeight = std::max(1, height / 2);
+        size_t row = (3 * nextWidth + 3) & ~3;
+        for (int32 y = 0; y < nextHeight; y++)
+        {
+            const unsigned char* row0 = source + sourceRow * std::min(2 * y, height - 1);
+            const unsigned char* row1 = source + sourceRow * std::min(2 * y + 1, height - 1);
+            for (int32 x = 0; x < nextWidth; x++)
+            {
+                int32 x0 = 3 * std::min(2 * x, width - 1);
+                int32 x1 = 3 * std::min(2 * x + 1, width - 1);
+                for (int32 c = 0; c < 3; c++)
+                    level[row * y + 3 * x + c] = (unsigned char)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4);
+            }
+        }
+
+        width = nextWidth;
+        height = nextHeight;
+    }
+
+    std::string cachePath = std::string(sourcePath) + TEXTURE_CACHE_EXTENSION;
+    FILE* output = fopen(cachePath.c_str(), "wb");
+    if (!output)
+        return false;
+
+    bool saved = fwrite(file.data(), 1, fileSize, output) == fileSize;
+    fclose(output);
+
+    // A partial file would only be rejected on every launch
+    if (!saved)
+        remove(cachePath.c_str());
+
+    return saved;
+}
@@ -0,0 +1,56 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include "Common.h"
+#include "MappedFile.h"
+
+class RgbImage;
+
+#define TEXTURE_CACHE_EXTENSION     ".cache"
+#define TEXTURE_CACHE_MAGIC         0x58545054 // "TPTX"
+#define TEXTURE_CACHE_VERSION       2
+#define TEXTURE_CACHE_MAX_LEVELS    32
+
+// Header of a texture saved next to its source as <source>.cache, followed by the whole mipmap
+// chain down to 1x1, level 0 first. Pixels are RGB with rows padded to four bytes, the default
+// unpack alignment, so every level goes to glTexImage2D as it is in the file.
+// The modification time and size of the source when it was converted identify stale files.
+struct TextureCacheHeader
+{
+    uint32 magic;
+    uint32 version;
+    int64 sourceTime;
+    int64 sourceSize;
+    int32 width;
+    int32 height;
+    uint32 channels;
+    uint32 levels;
+};
+
+// Converted texture mapped in memory, launches after the first one don't process any pixel
+class TextureCache
+{
+public:
+    TextureCache();
+
+    // Returns false if there is no cache for the current version of the source
+    bool Open(const char* sourcePath);
+    void Close();
+
+    bool IsOpen() const { return m_header != nullptr; }
+    uint32 GetLevelCount() const { return m_header ? m_header->levels : 0; }
+    const unsigned char* GetLevel(uint32 level, int32& width, int32& height) const;
+
+    // Builds the mipmap chain of the decoded source and writes its cache
+    static bool Write(const char* sourcePath, const RgbImage& image);
+
+private:
+    static bool GetSourceStamp(const char* sourcePath, int64& time, int64& size);
+    static uint32 GetLevelCount(int32 width, int32 height);
+    static size_t GetLevelSize(int32 width, int32 height) { return size_t((3 * width + 3) & ~3) * size_t(height); }
+
+    MappedFile m_file;
+    const TextureCacheHeader* m_header;
+};
+
+#endif
@@ -0,0 +1,32 @@
+#include "Common.h"
+#include "RgbImage.h"
+#include "TextureCache.h"
+
+// Converts textures to the cache format read by the game, with their whole mipmap chain,
+// so the first launch doesn't decode them either. The game converts stale or missing ones itself.
+// Usage: PracticaFinalTextureConverter file...
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        printf("Usage: %s file...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    uint32 failed = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        RgbImage image;
+        if (!image.LoadImageFile(argv[i]) || !TextureCache::Write(argv[i], image))
+        {
+            ERROR_LOG("Failed to convert %s\n", argv[i]);
+            failed++;
+            continue;
+        }
+
+        TextureCache cache;
+        printf("%s: %ldx%ld, %u levels\n", argv[i], image.GetNumCols(), image.GetNumRows(), cache.Open(argv[i]) ? cache.GetLevelCount() : 0);
+    }
+
+    return failed ? EXIT_FAILURE : 0;
+}
@@ -0,0 +1,103 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(uint32 threads) : m_queuedTasks(0), m_pendingTasks(0), m_nextWorker(0), m_stolenTasks(0)
+{
+    m_stopping = false;
+
+    threads = std::max<uint32>(1, threads);
+    for (uint32 i = 0; i < threads; i++)
+        m_workers.emplace_back(new Worker());
+
+    for (uint32 i = 0; i < threads; i++)
+        m_threads.emplace_back(&ThreadPool::Run, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_taskCondition.notify_all();
+
+    for (std::thread& thread : m_threads)
+        thread.join();
+}
+
+void ThreadPool::Submit(Task task)
+{
+    m_pendingTasks++;
+
+    // Counted before it is visible, a worker may pop and run the task before this function returns
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queuedTasks++;
+    }
+
+    Worker& worker = *m_workers[m_nextWorker++ % m_workers.size()];
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(std::move(task));
+    }
+    m_taskCondition.notify_one();
+}
+
+void ThreadPool::Wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_doneCondition.wait(lock, [this] { return m_pendingTasks == 0; });
+}
+
+bool ThreadPool::PopTask(uint32 index, Task& task)
+{
+    {
+        Worker& own = *m_workers[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    for (uint32 i = 1; i < m_workers.size(); i++)
+    {
+        Worker& victim = *m_workers[(index + i) % m_workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            m_stolenTasks++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::Run(uint32 index)
+{
+    while (true)
+    {
+        Task task;
+        if (PopTask(index, task))
+        {
+            m_queuedTasks--;
+            task();
+
+            if (--m_pendingTasks == 0)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_doneCondition.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_taskCondition.wait(lock, [this] { return m_stopping || m_queuedTasks > 0; });
+        if (m_stopping && m_queuedTasks == 0)
+            break;
+    }
+}
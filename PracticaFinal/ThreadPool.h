@@ -0,0 +1,55 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include "Common.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Fixed set of workers, each one with its own task queue. A worker takes tasks from the
+// back of its queue and, when it runs out, steals from the front of the others.
+class ThreadPool
+{
+public:
+    typedef std::function<void()> Task;
+
+    explicit ThreadPool(uint32 threads);
+    ~ThreadPool();
+
+    void Submit(Task task);
+
+    // Blocks until every submitted task has finished
+    void Wait();
+
+    uint32 GetThreadCount() const { return uint32(m_threads.size()); }
+    uint64 GetStolenTasks() const { return m_stolenTasks; }
+
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void Run(uint32 index);
+    bool PopTask(uint32 index, Task& task);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_taskCondition;
+    std::condition_variable m_doneCondition;
+
+    std::atomic<uint32> m_queuedTasks;
+    std::atomic<uint32> m_pendingTasks;
+    std::atomic<uint32> m_nextWorker;
+    std::atomic<uint64> m_stolenTasks;
+    bool m_stopping;
+};
+
+#endif
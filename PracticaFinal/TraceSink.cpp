@@ -0,0 +1,90 @@
+#include "TraceSink.h"
+#include <chrono>
+
+TraceSink::TraceSink(const char* filename, uint32 capacity /*=TRACE_DEFAULT_CAPACITY*/) : m_head(0), m_tail(0), m_dropped(0), m_running(false)
+{
+    // Round up to a power of two so indices wrap with a mask
+    uint32 size = 1;
+    while (size < capacity)
+        size <<= 1;
+
+    m_events = new TraceEvent[size];
+    m_mask = size - 1;
+
+    m_file = fopen(filename, "wb");
+    if (!m_file)
+    {
+        ERROR_LOG("Unable to open trace file: %s\n", filename);
+        return;
+    }
+
+    uint32 header[2] = { TRACE_FILE_MAGIC, uint32(sizeof(TraceEvent)) };
+    fwrite(header, sizeof(header), 1, m_file);
+
+    m_running = true;
+    m_thread = std::thread(&TraceSink::FlushLoop, this);
+}
+
+TraceSink::~TraceSink()
+{
+    if (m_thread.joinable())
+    {
+        m_running = false;
+        m_thread.join();
+    }
+
+    if (m_file)
+    {
+        Flush();
+        fclose(m_file);
+    }
+
+    if (m_dropped)
+        ERROR_LOG("Trace dropped %llu events.\n", uint64(m_dropped));
+
+    delete[] m_events;
+}
+
+void TraceSink::Record(uint32 type, uint64 time, int32 a /*=0*/, int32 b /*=0*/, int32 c /*=0*/)
+{
+    uint64 head = m_head.load(std::memory_order_relaxed);
+    if (!m_file || head - m_tail.load(std::memory_order_acquire) > m_mask)
+    {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    TraceEvent& event = m_events[head & m_mask];
+    event.time = time;
+    event.type = type;
+    event.a = a;
+    event.b = b;
+    event.c = c;
+
+    m_head.store(head + 1, std::memory_order_release);
+}
+
+void TraceSink::Flush()
+{
+    uint64 tail = m_tail.load(std::memory_order_relaxed);
+    uint64 head = m_head.load(std::memory_order_acquire);
+
+    while (tail != head)
+    {
+        // Write up to the end of the buffer, the wrapped part goes in the next iteration
+        uint64 index = tail & m_mask;
+        uint64 count = std::min<uint64>(head - tail, m_mask + 1 - index);
+        fwrite(&m_events[index], sizeof(TraceEvent), size_t(count), m_file);
+        tail += count;
+        m_tail.store(tail, std::memory_order_release);
+    }
+}
+
+void TraceSink::FlushLoop()
+{
+    while (m_running)
+    {
+        Flush();
+        std::this_thread::sleep_for(std::chrono::milliseconds(TRACE_FLUSH_MILLISECONDS));
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef TRACE_SINK_H
+#define TRACE_SINK_H
+
+#include "Common.h"
+#include <atomic>
+#include <thread>
+
+#define TRACE_DEFAULT_CAPACITY      4096 // Events, must be a power of two
+#define TRACE_FLUSH_MILLISECONDS    10
+#define TRACE_FILE_MAGIC            0x31435254 // "TRC1"
+
+enum TraceEventType
+{
+    TRACE_SPAWN,        // a = block type, b = 1 if active, 0 if next
+    TRACE_LOCK,         // a = block type, b = x, c = y
+    TRACE_CLEAR,        // a = cleared rows mask, b = lines cleared
+    TRACE_ROTATE,       // a = block type, b = new rotation
+    TRACE_GAME_OVER     // a = lines completed, b = points
+};
+
+struct TraceEvent
+{
+    uint64 time;
+    uint32 type;
+    int32 a;
+    int32 b;
+    int32 c;
+};
+
+// Binary event recorder. The game thread writes events into a single producer / single
+// consumer ring buffer without locks, and a background thread appends them to a file.
+// Events are dropped (and counted) if the buffer fills up before being flushed.
+class TraceSink
+{
+public:
+    TraceSink(const char* filename, uint32 capacity = TRACE_DEFAULT_CAPACITY);
+    ~TraceSink();
+
+    bool IsOpen() const { return m_file != nullptr; }
+
+    void Record(uint32 type, uint64 time, int32 a = 0, int32 b = 0, int32 c = 0);
+
+    uint64 GetRecordedEvents() const { return m_head; }
+    uint64 GetDroppedEvents() const { return m_dropped; }
+
+private:
+    void FlushLoop();
+    void Flush();
+
+    TraceEvent* m_events;
+    uint32 m_mask;
+
+    std::atomic<uint64> m_head;     // Next event to write, only the producer changes it
+    std::atomic<uint64> m_tail;     // Next event to flush, only the consumer changes it
+    std::atomic<uint64> m_dropped;
+    std::atomic<bool> m_running;
+
+    FILE* m_file;
+    std::thread m_thread;
+};
+
+#endif
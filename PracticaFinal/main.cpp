@@ -1,38 +1,64 @@
 #pragma once
 
 #include <GL/glew.h>
+#ifdef _WIN32
+#include <GL/wglew.h>
+#endif
 #include <GL/freeglut.h>
 #include "Common.h"
+#include "AllocationCounter.h"
+#include "AssetManager.h"
 #include "Block.h"
 #include "Game.h"
 #include "RgbImage.h"
-
+#include "CubeRenderer.h"
+#include "FrameCapture.h"
+#include "Panel.h"
+#include "RenderQueue.h"
+#include "ShaderRenderer.h"
+#include <chrono>
+#include <cstring>
+
+#define WINDOW_TITLE    "Practica Final"
 #define SCREEN_SIZE     1000, 500
 #define SCREEN_POSITION 800,  400
 #define SCREEN_COLOR     0.0, 0.0, 0.0, 0.0
 #define DOUBLE_CLICK_TIME 250
+#define TARGET_FPS        60
+#define PAUSED_FPS        4  // Only the pause screen is shown
+#define VSYNC_ENABLED     1
+#define FRAME_STATS_FRAMES 120
+#define GHOST_ALPHA       RENDER_TRANSLUCENT_ALPHA // Same landing preview in every render path
 
 void initFunc();
 void funReshape(int w, int h);
 void funDisplay();
-void funIdle();
+void funTimer(int value);
 void funKeyboardUp(unsigned char key, int x, int y);
 void funSpecial(int key, int x, int y);
 void funMouse(int key, int state, int x, int y);
 void funMotion(int x, int y);
 void funMotionPassive(int x, int y);
 void funMouseWheel(int wheel, int direction, int x, int y);
+void togglePause();
 void drawFrame();
+void drawShaderFrame();
+void updateWindowTitle();
+void initPanel();
 void drawPanel();
+void funClose();
 void drawBlocks();
+void fillBlockBatch();
 void drawPause();
+void drawPauseQuad();
 void drawPlane(GLfloat size);
 void drawBlock(Block* block);
-void drawSubBlock(SubBlock* sub);
-void drawBasicBlock(bool withBorder = true);
+void drawGhost(Block* block);
+bool isGhostVisible();
+void drawCell(int32 x, int32 y, uint8 cellColor);
+void drawUnitCube();
 void initLights();
 void initTextures();
-void selectColor(uint8 color);
 void generateRandomBlock();
 void renderText(float x, float y, void *font, const unsigned char* string);
 void drawPoints();
@@ -45,8 +71,6 @@ GLfloat currentRotationZ        = 0.0;
 
 GLfloat ambientLightIntensity[]   = { 0.2f, 0.2f, 0.2f, 0.2f };
 
-uint8 color = COLOR_WHITE;
-
 int32 oldX = 0, oldY = 0;
 
 uint32 lastClickTime = 0;
@@ -59,18 +83,80 @@ bool stopped = false;
 
 bool soundPaused = true;
 
+const GLuint numTextures = 2;
+GLuint textureName[numTextures];
+const char* textureFile[numTextures] = { "../src/textura.bmp", "../src/tetris.bmp" };
+uint32 textureAsset[numTextures];
+AssetManager assetManager;
+
+CubeRenderer cubeRenderer;
+CubeBatch panelBatch;
+CubeBatch blockBatch;
+CubeBatch ghostBatch;
+bool showGhost = true;
+GLuint panelList = 0;
+RenderQueue renderQueue;
+FrameCapture frameCapture;
+
+// Chosen at startup: -shader for the core profile renderer, -immediate to disable instancing
+bool useShaderRenderer = false;
+bool useImmediateMode = false;
+ShaderRenderer shaderRenderer;
+uint32 titlePoints = 0;
+uint32 titleLevel = 0;
+
+// CPU time spent submitting frames, reported every FRAME_STATS_FRAMES frames at debug log level
+uint32 statsFrames = 0;
+double statsSubmitMicroseconds = 0.0;
+uint32 statsEliminatedCalls = 0;
+uint64 statsAllocations = 0; // Heap allocations of game updates and frames, debug builds only
+
+uint32 targetFps = TARGET_FPS;
+
+int32 nextFrameTime = 0;
+
+// Camera or overlay changes, together with the game generation it decides if a frame is needed
+uint32 viewGeneration = 0;
+uint32 drawnViewGeneration = 0;
+uint32 drawnGameGeneration = 0;
+
 int main(int argc, char** argv) {
-    
-    srand(unsigned int(time(nullptr)));
 
     // Inicializamos OpenGL
     glutInit(&argc, argv);
+
+    // Optional frame rate and renderer, after glutInit removed its own arguments
+    for (int i = 1; i < argc; i++)
+    {
+        char* end = nullptr;
+        long fps = strtol(argv[i], &end, 10);
+
+        if (!strcmp(argv[i], "-shader"))
+            useShaderRenderer = true;
+        else if (!strcmp(argv[i], "-immediate"))
+            useImmediateMode = true;
+        else if (end != argv[i] && *end == '\0' && fps > 0)
+            targetFps = uint32(fps);
+        else
+            ERROR_LOG("Ignoring unknown argument: %s\n", argv[i]);
+    }
+
+    // Textures are decoded in the background while the window is created
+    for (unsigned i = 0; i < numTextures; i++)
+        textureAsset[i] = assetManager.RequestTexture(textureFile[i]);
+
+    if (useShaderRenderer)
+    {
+        glutInitContextVersion(3, 3);
+        glutInitContextProfile(GLUT_CORE_PROFILE);
+    }
+
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
 
     // Inicializamos la Ventana
     glutInitWindowSize(SCREEN_SIZE);
     glutInitWindowPosition(SCREEN_POSITION);
-    glutCreateWindow("Practica Final");
+    glutCreateWindow(WINDOW_TITLE);
 
     // Inicializaciones especficas
     initFunc();
@@ -83,16 +169,19 @@ int main(int argc, char** argv) {
     glutMouseFunc(funMouse);
     glutMotionFunc(funMotion);
     glutPassiveMotionFunc(funMotionPassive);
-    glutIdleFunc(funIdle);
     glutMouseWheelFunc(funMouseWheel);
+    glutCloseFunc(funClose);
 
-    game = Game::CreateNewGame();
+    game = Game::CreateNewGame(DEFAULT_LEVEL, uint64(time(nullptr)));
     if (!game)
         return(1);
     
     PlaySoundTetris(TEXT("../src/main.wav"), nullptr, SND_LOOP | SND_ASYNC);
     game->StartGame();
 
+    // Frames are scheduled by a timer, the loop sleeps in between
+    nextFrameTime = glutGet(GLUT_ELAPSED_TIME);
+    glutTimerFunc(0, funTimer, 0);
 
     // Bucle principal
     glutMainLoop();
@@ -104,27 +193,49 @@ int main(int argc, char** argv) {
 void initFunc() {
 
     // Inicializamos GLEW
+    glewExperimental = GL_TRUE;
     GLenum err = glewInit();
     if (GLEW_OK != err) {
-        DEBUG_LOG("Error: %s\n", glewGetErrorString(err));
+        ERROR_LOG("Error: %s\n", glewGetErrorString(err));
     }
-    DEBUG_LOG("Status: Using GLEW %s\n", glewGetString(GLEW_VERSION));
+    glGetError(); // glewInit may leave an error behind in core profile contexts
+    INFO_LOG("Status: Using GLEW %s\n", glewGetString(GLEW_VERSION));
 
     // Configuracion de parametros fijos
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_POLYGON_OFFSET_FILL);
     glEnable(GL_CULL_FACE);
-    initLights();
+    if (!useShaderRenderer)
+        initLights();
     initTextures();
+    if (useShaderRenderer)
+    {
+        if (!shaderRenderer.Init(textureName[0], textureName[1]))
+        {
+            ERROR_LOG("Failed to initialize the shader renderer. Stopping...\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    else if (!useImmediateMode)
+        cubeRenderer.Init(textureName[0]);
+    initPanel();
+    frameCapture.Init();
     //initTextures();
     //glEnable(GL_CULL_FACE);
     //glCullFace(GL_BACK);
     glPolygonOffset(1.0, 1.0);
-    glShadeModel(GL_SMOOTH);
+    if (!useShaderRenderer)
+        glShadeModel(GL_SMOOTH);
     //glEnable(GL_NORMALIZE);
     //glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
     lastClickTime = glutGet(GLUT_ELAPSED_TIME);
+
+#ifdef _WIN32
+    // Swap at most once per refresh so the driver does not spin either
+    if (WGLEW_EXT_swap_control)
+        wglSwapIntervalEXT(VSYNC_ENABLED);
+#endif
 }
 
 void initLights()
@@ -170,26 +281,22 @@ void initLights()
     }
 }
 
-const GLuint numTextures = 2;
-GLuint textureName[numTextures];
-
 void initTextures()
 {
-    glEnable(GL_TEXTURE_2D);
-    glGenTextures(numTextures-1, textureName);
-    
-    const char *filename[numTextures] = { "../src/textura.bmp", "../src/tetris.bmp" };
+    if (!useShaderRenderer)
+        glEnable(GL_TEXTURE_2D);
+
+    // Each texture is uploaded once, with mipmaps generated by the GPU
+    assetManager.UploadTextures();
 
     for(unsigned i = 0; i < numTextures; i++)
     {
-        // Cargamos la textura
+        textureName[i] = assetManager.GetTexture(textureAsset[i]);
         glBindTexture(GL_TEXTURE_2D, textureName[i]);
-        RgbImage texture(filename[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, texture.GetNumCols(), texture.GetNumRows(), 0, GL_RGB, GL_UNSIGNED_BYTE, texture.ImageData());
-        gluBuild2DMipmaps(GL_TEXTURE_2D, 3, texture.GetNumCols(), texture.GetNumRows(), GL_RGB, GL_UNSIGNED_BYTE, texture.ImageData());
     
         // Configuramos la textura
-        glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_BLEND);
+        if (!useShaderRenderer)
+            glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_BLEND);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
         /*glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -203,6 +310,12 @@ void initTextures()
 
 void funReshape(int w, int h) {
 
+    if (useShaderRenderer)
+    {
+        shaderRenderer.SetViewport(w, h);
+        return;
+    }
+
     // Configuramos el Viewport
     glViewport(0, 0, w, h);
 
@@ -230,20 +343,25 @@ void funKeyboardUp(unsigned char key, int x, int y)
         lookat[0] = 2.0f;
         lookat[1] = 3.0f;
         lookat[2] = -8.0f;
+        viewGeneration++;
         break;
     case 'c':
         game->ChangeBlock();
         break;
+    case 'p':
+        frameCapture.Request();
+        viewGeneration++;
+        break;
+    case 'g':
+        showGhost = !showGhost;
+        viewGeneration++;
+        break;
     case ' ':
         game->RotateActiveBlock();
         break;
     case 13: // Enter
     case 27: // ESC
-        stopped = !stopped;
-        if (stopped)
-            game->PauseGame();
-        else
-            game->ResumeGame();
+        togglePause();
         break;
     case '+':
         game->SetLevel(game->GetLevel() + 1);
@@ -288,7 +406,7 @@ void funMouse(int key, int state, int x, int y)
     if (state == GLUT_UP)
     {   
         if ((glutGet(GLUT_ELAPSED_TIME) - lastClickTime) < DOUBLE_CLICK_TIME)
-            stopped = !stopped;
+            togglePause();
 
         lastClickTime = glutGet(GLUT_ELAPSED_TIME);
     }
@@ -313,6 +431,7 @@ void funMotion(int x, int y)
 
         oldX = x;
         oldY = y;
+        viewGeneration++;
     }
 
     DEBUG_LOG("MOTION: x: %d, y: %d \n", x, y);
@@ -324,66 +443,191 @@ void funMotion(int x, int y)
 void funMouseWheel(int wheel, int direction, int x, int y)
 {
     cameraPos[2] = std::min<GLfloat>(MIN_ZOOM, std::max<GLfloat>(MAX_ZOOM, cameraPos[2] - direction * 0.3f));
+    viewGeneration++;
     DEBUG_LOG("MOUSEWHEEL: wheel: %d, direction: %d, x: %d, y: %d, positionZ: %f \n", wheel, direction, x, y, cameraPos[2]);
 }
 
+// The game clock must not count the time spent paused
+void togglePause()
+{
+    stopped = !stopped;
+    viewGeneration++;
+    if (stopped)
+        game->PauseGame();
+    else
+        game->ResumeGame();
+}
+
+void funClose()
+{
+    // Last chance to free GL objects while the context still exists
+    if (panelList)
+        glDeleteLists(panelList, 1);
+
+    panelBatch.Release();
+    blockBatch.Release();
+    ghostBatch.Release();
+    cubeRenderer.Release();
+    shaderRenderer.Release();
+    frameCapture.Release();
+    assetManager.Release();
+}
+
 void funDisplay()
 {
     drawFrame();
 }
 
-void funIdle()
+void funTimer(int value)
 {
+    uint64 allocationsStart = GetThreadAllocations();
     if (!stopped)
         game->Update();
+    statsAllocations += GetThreadAllocations() - allocationsStart;
 
-    drawFrame();
+    // Nothing to submit if neither the game nor the view changed since the last frame
+    if (game->GetGeneration() != drawnGameGeneration || viewGeneration != drawnViewGeneration)
+        glutPostRedisplay();
+
+    // Keep a steady cadence, skip the missed frames instead of queueing them
+    int32 frameTime = 1000 / int32(stopped ? PAUSED_FPS : targetFps);
+    int32 now = glutGet(GLUT_ELAPSED_TIME);
+    nextFrameTime += frameTime;
+    if (nextFrameTime < now)
+        nextFrameTime = now;
+
+    glutTimerFunc(uint32(nextFrameTime - now), funTimer, value);
 }
 
 void drawFrame()
 {
-    // Borramos el buffer de color y el de profundidad
-    glClearColor(SCREEN_COLOR);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-    // Posicionamos la cmara (V)
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
-
-    // Posicionamos la cmara (V)
-    gluLookAt(cameraPos[0], cameraPos[1], cameraPos[2],
-                 lookat[0],    lookat[1],    lookat[2],
-                     up[0],        up[1],        up[2]);
+    std::chrono::high_resolution_clock::time_point submitStart = std::chrono::high_resolution_clock::now();
+    uint64 allocationsStart = GetThreadAllocations();
+    drawnGameGeneration = game->GetGeneration();
+    drawnViewGeneration = viewGeneration;
+
+    if (useShaderRenderer)
+        drawShaderFrame();
+    else
+    {
+        // Borramos el buffer de color y el de profundidad
+        glClearColor(SCREEN_COLOR);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        // Posicionamos la cmara (V)
+        glMatrixMode(GL_MODELVIEW);
+        glLoadIdentity();
+
+        // Posicionamos la cmara (V)
+        gluLookAt(cameraPos[0], cameraPos[1], cameraPos[2],
+                     lookat[0],    lookat[1],    lookat[2],
+                         up[0],        up[1],        up[2]);
     
-    glScaled(0.5f, 0.5f, 0.5f);
-    drawPanel();
-    drawBlocks();
-    glScaled(1.0f, 1.0f, 1.0f);
+        glScaled(0.5f, 0.5f, 0.5f);
+        drawPanel();
+        drawBlocks();
+        glScaled(1.0f, 1.0f, 1.0f);
 
-    if (stopped)
-        drawPause();
+        if (stopped)
+            drawPause();
 
-    drawPoints();
+        renderQueue.Flush();
+        statsEliminatedCalls += renderQueue.GetStats().eliminatedCalls;
+
+        drawPoints();
+    }
 
     //DEBUG_LOG("points = %u : %s", game->GetPoints(), std::to_string(game->GetPoints()));
+
+    statsSubmitMicroseconds += std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - submitStart).count();
+    statsAllocations += GetThreadAllocations() - allocationsStart;
+    if (++statsFrames == FRAME_STATS_FRAMES)
+    {
+        DEBUG_LOG("Frame submission: %.1f us, %u redundant state calls skipped, average over %u frames\n", statsSubmitMicroseconds / statsFrames, statsEliminatedCalls / statsFrames, statsFrames);
+#ifdef ALLOCATION_COUNTER_ENABLED
+        DEBUG_LOG("Heap allocations in updates and frames: %llu over %u frames\n", statsAllocations, statsFrames);
+#endif
+        statsAllocations = 0;
+        statsFrames = 0;
+        statsSubmitMicroseconds = 0.0;
+        statsEliminatedCalls = 0;
+    }
     
+    // Starts the readback of a requested capture, the frame after collects it
+    frameCapture.EndFrame();
+    if (frameCapture.IsPending())
+        viewGeneration++;
+
     // Intercambiamos los buffers
     glutSwapBuffers();
 }
 
+void drawShaderFrame()
+{
+    shaderRenderer.BeginFrame(cameraPos, lookat, up);
+    shaderRenderer.Draw(panelBatch);
+
+    fillBlockBatch();
+    shaderRenderer.Draw(blockBatch);
+    shaderRenderer.Draw(ghostBatch, GHOST_ALPHA);
+
+    if (stopped)
+        shaderRenderer.DrawPause();
+
+    // Bitmap fonts need the fixed-function pipeline, the score goes in the title instead
+    updateWindowTitle();
+}
+
+void updateWindowTitle()
+{
+    if (game->GetPoints() == titlePoints && game->GetLevel() == titleLevel)
+        return;
+
+    titlePoints = game->GetPoints();
+    titleLevel = game->GetLevel();
+
+    char title[BUFFER_SIZE];
+    snprintf(title, BUFFER_SIZE, WINDOW_TITLE " - Puntuacion: %u - Nivel: %u", titlePoints, titleLevel);
+    glutSetWindowTitle(title);
+}
+
+void fillBlockBatch()
+{
+    blockBatch.Clear();
+    blockBatch.AddBlock(game->GetActiveBlock());
+    blockBatch.AddBlock(game->GetNextBlock());
+
+    game->GetBoard().ForEachCell([](int32 x, int32 y, uint8 color) { blockBatch.AddCube(float(x), float(y), 0.0f, color); });
+
+    ghostBatch.Clear();
+    if (isGhostVisible())
+        ghostBatch.AddBlock(game->GetActiveBlock(), game->GetGhostY());
+}
+
 void drawBlocks()
 {
-    // Draw the active falling block
+    // Every cube in one instanced draw call when supported
+    if (cubeRenderer.IsAvailable())
+    {
+        fillBlockBatch();
+        cubeRenderer.Draw(blockBatch);
+        cubeRenderer.Draw(ghostBatch, GHOST_ALPHA);
+        return;
+    }
+
+    // Draw the active falling block and where it would land
     if (game->GetActiveBlock())
+    {
         drawBlock(game->GetActiveBlock());
+        drawGhost(game->GetActiveBlock());
+    }
 
     // Draw the next block
     if (game->GetNextBlock())
         drawBlock(game->GetNextBlock());
 
-    // Draw other subBlocks
-    for (SubBlock* sub : game->GetSubBlockList())
-        drawSubBlock(sub);
+    // Draw the cells locked in the board
+    game->GetBoard().ForEachCell(drawCell);
 }
 
 void drawBlock(Block* block)
@@ -393,137 +637,37 @@ void drawBlock(Block* block)
 
     if (block->GetType() > MAX_BLOCK_TYPE)
     {
-        DEBUG_LOG("Block type not supported: type (%d)", block->GetType());
+        ERROR_LOG("Block type not supported: type (%d)\n", block->GetType());
         exit(1);
     }
-    
-    color = block->GetColor();
-    std::vector<SubBlock*> subBlocks = block->GetSubBlocks();
-
-    float correction[2] = {0.0f, 0.0f};
-    
-    glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, textureName[0]);
-    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_BLEND);
-    
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-    glPushMatrix();
-    {
-        glTranslatef(block->GetPositionX() + correction[0], block->GetPositionY() + correction[1], block->GetPositionZ());
+    const BlockRotation& rotation = Block::GetRotationOfType(block->GetType(), block->GetRotation());
+    for (uint8 i = 0; i < NUM_BLOCK_SUBBLOCKS; i++)
+        renderQueue.Submit(drawUnitCube, GLfloat(block->GetPositionX() + rotation.cells[i].x), GLfloat(block->GetPositionY() + rotation.cells[i].y), 0.0f, textureName[0], RENDER_BLEND_BLEND, block->GetColor());
+}
 
-        // Cube should not rotate
-        //if (block->GetType() != TYPE_CUBE)
-        //    glRotatef(block->GetRotation(), 0.0f, 0.0f, 1.0f);
+bool isGhostVisible()
+{
+    // Hidden once the block already rests where it would land
+    const Block* block = game->GetActiveBlock();
+    return showGhost && block && !game->IsGameOver() && game->GetGhostY() != block->GetPositionY();
+}
 
-        if (correction[0] != 0.0f || correction[1] != 0.0f)
-            glTranslatef(-correction[0], -correction[1], 0.0f);
+void drawGhost(Block* block)
+{
+    if (!isGhostVisible())
+        return;
 
-        for (SubBlock* sub : subBlocks)
-        {
-            glPushMatrix();
-            glTranslatef(sub->GetPositionX(), sub->GetPositionY(), sub->GetPositionZ());
-            drawBasicBlock();
-            glPopMatrix();
-        }
-    }
-    glPopMatrix();
-    glDisable(GL_TEXTURE_2D);
+    // Queued as translucent, drawn after the opaque cubes of the frame
+    int32 ghostY = game->GetGhostY();
+    const BlockRotation& rotation = Block::GetRotationOfType(block->GetType(), block->GetRotation());
+    for (uint8 i = 0; i < NUM_BLOCK_SUBBLOCKS; i++)
+        renderQueue.Submit(drawUnitCube, GLfloat(block->GetPositionX() + rotation.cells[i].x), GLfloat(ghostY + rotation.cells[i].y), 0.0f, textureName[0], RENDER_BLEND_TRANSLUCENT, block->GetColor());
 }
 
-void drawSubBlock(SubBlock* sub)
+void drawCell(int32 x, int32 y, uint8 cellColor)
 {
-    color = sub->GetColor();
-    glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, textureName[0]);
-    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_BLEND);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glPushMatrix();
-    glTranslatef(sub->GetPositionX(), sub->GetPositionY(), sub->GetPositionZ());
-    drawBasicBlock();
-    glPopMatrix();
-    glDisable(GL_TEXTURE_2D);
-}
-
-void selectColor(uint8 color)
-{
-    switch(color)
-    {
-    case COLOR_WHITE:
-    {
-        GLfloat Kad[] = {1.0, 1.0, 1.0, 1.0};
-        glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, Kad);
-        glColor3f(1.0, 1.0, 1.0);
-        break;
-    }
-    case COLOR_BLACK:
-    {
-        GLfloat Kad[] = {0.0, 0.0, 0.0, 1.0};
-        glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, Kad);
-        glColor3f(0.0, 0.0, 0.0);
-        break;
-    }
-    case COLOR_RED:
-    {
-        GLfloat Kad[] = {0.863f, 0.078f, 0.235f, 1.0};
-        glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, Kad);
-        glColor3f(0.863f, 0.078f, 0.235f);
-        break;
-    }
-    case COLOR_BLUE:
-    {
-        GLfloat Kad[] = {0.118f, 0.565f, 1.000f, 1.0};
-        glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, Kad);
-        glColor3f(0.118f, 0.565f, 1.000f);
-        break;
-    }
-    case COLOR_GREEN:
-    {
-        GLfloat Kad[] = {0.235f, 0.702f, 0.443f, 1.0};
-        glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, Kad);
-        glColor3f(0.235f, 0.702f, 0.443f);
-        break;
-    }
-    case COLOR_YELLOW:
-    {
-        GLfloat Kad[] = {1.0, 1.0, 0.0, 1.0};
-        glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, Kad);
-        glColor3f(1.0, 1.0, 0.0);
-        break;
-    }
-    case COLOR_PINK:
-    {
-        GLfloat Kad[] = {1.0, 0.0, 0.5, 1.0};
-        glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, Kad);
-        glColor3f(1.0, 0.0, 0.5);
-        break;
-    }
-    case COLOR_ORANGE:
-    {
-        GLfloat Kad[] = {1.0, 0.5, 0.0, 1.0};
-        glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, Kad);
-        glColor3f(1.0, 0.5, 0.0);
-        break;
-    }
-    case COLOR_GRAY:
-    {
-        GLfloat Kad[] = {0.653f, 0.653f, 0.653f, 1.0};
-        glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, Kad);
-        glColor3f(0.753f, 0.753f, 0.753f);
-        break;
-    }
-    case COLOR_CYAN:
-    {
-        GLfloat Kad[] = {0.902f, 0.902f, 0.980f, 1.0};
-        glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, Kad);
-        glColor3f(0.902f, 0.902f, 0.980f);
-        break;
-    }
-    default:
-        break;
-    }
+    renderQueue.Submit(drawUnitCube, float(x), float(y), 0.0f, textureName[0], RENDER_BLEND_BLEND, cellColor);
 }
 
 void drawCube(GLfloat size)
@@ -575,24 +719,18 @@ void drawCube(GLfloat size)
 
 void drawPause()
 {
-    glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, textureName[1]);
-    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glPushMatrix();
-    {
-        glTranslatef(4.0f, 6.0f, 10.0f);
-        glScalef(4.0f, 4.0f, 4.0f);
-        glBegin(GL_QUADS);
-	        glTexCoord2f(0.0f, 0.0f); glVertex3f(-2.5f, -1.0f,  1.0f);
-	        glTexCoord2f(1.0f, 0.0f); glVertex3f( 2.5f, -1.0f,  1.0f);
-	        glTexCoord2f(1.0f, 1.0f); glVertex3f( 2.5f,  1.0f,  1.0f);
-	        glTexCoord2f(0.0f, 1.0f); glVertex3f(-2.5f,  1.0f,  1.0f);
-        glEnd();
-    }
-    glPopMatrix();
-    glDisable(GL_TEXTURE_2D);
+    renderQueue.Submit(drawPauseQuad, 4.0f, 6.0f, 10.0f, textureName[1], RENDER_BLEND_REPLACE, COLOR_WHITE);
+}
+
+void drawPauseQuad()
+{
+    glScalef(4.0f, 4.0f, 4.0f);
+    glBegin(GL_QUADS);
+	    glTexCoord2f(0.0f, 0.0f); glVertex3f(-2.5f, -1.0f,  1.0f);
+	    glTexCoord2f(1.0f, 0.0f); glVertex3f( 2.5f, -1.0f,  1.0f);
+	    glTexCoord2f(1.0f, 1.0f); glVertex3f( 2.5f,  1.0f,  1.0f);
+	    glTexCoord2f(0.0f, 1.0f); glVertex3f(-2.5f,  1.0f,  1.0f);
+    glEnd();
 }
 
 void drawPlane(GLfloat size)
@@ -606,114 +744,34 @@ void drawPlane(GLfloat size)
     glEnd();
 }
 
-void drawBasicBlock(bool withBorder /*=true*/)
+void drawUnitCube()
 {
-    selectColor(color);
-    
-    glEnable(GL_TEXTURE_2D);
-    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_BLEND);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
     drawCube(1.0f);
-
-    glDisable(GL_TEXTURE_2D);
-    //glutSolidCube(1.0f);
-
-
-    /*if (withBorder)
-    {
-        glLineWidth(2.0);
-        selectColor(COLOR_BLACK);
-        glutWireCube(1.0f);
-    }*/
 }
 
-void drawPanel()
+void initPanel()
 {
-    uint8 oldColor = color;
-    color = COLOR_GRAY;
-    glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, textureName[0]);
-    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_BLEND);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glPushMatrix();
-    {
-        glTranslatef(0.0, -1.0, 0.0);
-        for (uint8 i = 0; i < MAX_WIDTH; i++)
-        {
-            drawBasicBlock();
-            glTranslatef(1.0, 0.0, 0.0);
-        }
-    }
-    glPopMatrix();
+    ForEachPanelCell([](float x, float y) { panelBatch.AddCube(x, y, 0.0f, COLOR_GRAY); });
 
-    glPushMatrix();
-    {
-        glTranslatef(-1.0, -1.0, 0.0);
-        for (uint8 i = 0; i < MAX_HEIGHT; i++)
-        {
-            drawBasicBlock();
-            glTranslatef(0.0, 1.0, 0.0);
-        }
-    }
-    glPopMatrix();
-
-    glPushMatrix();
-    {
-        glTranslatef(MAX_WIDTH, -1.0, 0.0);
-        for (uint8 i = 0; i < MAX_HEIGHT; i++)
-        {
-            drawBasicBlock();
-            glTranslatef(0.0, 1.0, 0.0);
-        }
-    }
-    glPopMatrix();
+    if (useShaderRenderer || cubeRenderer.IsAvailable())
+        return;
 
-    glPushMatrix();
-    {
-        glTranslatef(DISPLAY_NEXT_BLOCK_X, DISPLAY_NEXT_BLOCK_Y, 0.0);
-        for (uint8 i = 0; i < DISPLAY_NEXT_BLOCK_HEIGHT; i++)
-        {
-            drawBasicBlock();
-            glTranslatef(0.0, 1.0, 0.0);
-        }
-    }
-    glPopMatrix();
+    // The panel never changes, the immediate-mode path records it once in a display list
+    for (const CubeInstance& cube : panelBatch.GetInstances())
+        renderQueue.Submit(drawUnitCube, cube.x, cube.y, cube.z, textureName[0], RENDER_BLEND_BLEND, COLOR_GRAY);
 
-    glPushMatrix();
-    {
-        glTranslatef(DISPLAY_NEXT_BLOCK_X + DISPLAY_NEXT_BLOCK_WITDH, DISPLAY_NEXT_BLOCK_Y, 0.0);
-        for (uint8 i = 0; i < DISPLAY_NEXT_BLOCK_HEIGHT + 1; i++)
-        {
-            drawBasicBlock();
-            glTranslatef(0.0, 1.0, 0.0);
-        }
-    }
-    glPopMatrix();
+    panelList = glGenLists(1);
+    glNewList(panelList, GL_COMPILE);
+    renderQueue.Flush();
+    glEndList();
+}
 
-    glPushMatrix();
-    {
-        glTranslatef(DISPLAY_NEXT_BLOCK_X, DISPLAY_NEXT_BLOCK_Y, 0.0);
-        for (uint8 i = 0; i < DISPLAY_NEXT_BLOCK_WITDH; i++)
-        {
-            drawBasicBlock();
-            glTranslatef(1.0, 0.0, 0.0);
-        }
-    }
-    glPopMatrix();
-    glPushMatrix();
-    {
-        glTranslatef(DISPLAY_NEXT_BLOCK_X, DISPLAY_NEXT_BLOCK_Y + DISPLAY_NEXT_BLOCK_HEIGHT, 0.0);
-        for (uint8 i = 0; i < DISPLAY_NEXT_BLOCK_WITDH; i++)
-        {
-            drawBasicBlock();
-            glTranslatef(1.0, 0.0, 0.0);
-        }
-    }
-    glPopMatrix();
-    color = oldColor;
-    glDisable(GL_TEXTURE_2D);
+void drawPanel()
+{
+    if (cubeRenderer.IsAvailable())
+        cubeRenderer.Draw(panelBatch);
+    else
+        glCallList(panelList);
 }
 
 void renderText(float x, float y, void *font, const unsigned char* string)
@@ -724,8 +782,8 @@ void renderText(float x, float y, void *font, const unsigned char* string)
 
 void drawPoints()
 {
+    // Formatted on the stack, drawn every frame
     unsigned char points[BUFFER_SIZE];
-    std::string pointsString = " Puntuacion: " + std::to_string(game->GetPoints()) + "\n Nivel: " + std::to_string(game->GetLevel()) + "\n Velocidad: " + std::to_string(game->GetSpeed());
-    strcpy_s((char*)points, BUFFER_SIZE, pointsString.c_str());
+    snprintf((char*)points, BUFFER_SIZE, " Puntuacion: %u\n Nivel: %u\n Velocidad: %f", game->GetPoints(), game->GetLevel(), game->GetSpeed());
     renderText(POINTS_X, POINTS_Y, GLUT_BITMAP_9_BY_15, points);
 }